@@ -115,10 +115,42 @@ $releaseFirmware = "$releasesFolder\firmware-v$Version.bin"
 Copy-Item $firmwarePath $releaseFirmware -Force
 Write-Host "      Copied to $releaseFirmware" -ForegroundColor Green
 
+# Delta patch against the previous release, for devices updating from it (optional)
+$releaseAssets = @($releaseFirmware)
+$ErrorActionPreference = "SilentlyContinue"
+$previousTag = git describe --tags --abbrev=0 2>$null
+$ErrorActionPreference = "Stop"
+$previousFirmware = "$releasesFolder\firmware-$previousTag.bin"
+$pythonExists = Get-Command python -ErrorAction SilentlyContinue
+if ($previousTag -and $previousTag -ne "v$Version" -and (Test-Path $previousFirmware) -and $pythonExists) {
+    $releaseDelta = "$releasesFolder\firmware-delta-$previousTag.patch"
+    python tools\make_delta.py $previousFirmware $firmwarePath $releaseDelta
+    if ($LASTEXITCODE -eq 0) {
+        $releaseAssets += $releaseDelta
+        Write-Host "      Delta patch from ${previousTag}: $releaseDelta" -ForegroundColor Green
+    } else {
+        Write-Host "      Delta patch failed - release will be full image only" -ForegroundColor Yellow
+    }
+} else {
+    Write-Host "      No delta patch (previous firmware or python not found)" -ForegroundColor Gray
+}
+
+# Small manifest the devices poll instead of the GitHub API (see OTAUpdater::fetchManifest)
+$releaseManifest = "$releasesFolder\manifest.txt"
+$firmwareHash = (Get-FileHash $releaseFirmware -Algorithm SHA256).Hash.ToLower()
+$manifest = "version=v$Version`nsize=$fileSize`nsha256=$firmwareHash`n"
+if ($releaseAssets.Count -gt 1) {
+    $deltaSize = (Get-Item $releaseDelta).Length
+    $manifest += "delta=$previousTag`ndelta_size=$deltaSize`n"
+}
+Set-Content $releaseManifest $manifest -NoNewline
+$releaseAssets += $releaseManifest
+Write-Host "      Manifest written to $releaseManifest" -ForegroundColor Green
+
 # Step 5: Stage and commit changes
 Write-Host "`n[5/8] Committing changes..." -ForegroundColor Yellow
 git add -A
-git add -f $releaseFirmware
+git add -f $releaseAssets
 git commit -m "Release v$Version - $Message"
 if ($LASTEXITCODE -ne 0) {
     Write-Host "      Commit failed (may already be committed)" -ForegroundColor Yellow
@@ -210,7 +242,7 @@ $Message
         # Release exists, just upload the binary and ensure it's published
         Write-Host "      Release already exists, uploading binary and publishing..." -ForegroundColor Cyan
         $ErrorActionPreference = "SilentlyContinue"
-        gh release upload "v$Version" $releaseFirmware --clobber 2>&1 | Out-Null
+        gh release upload "v$Version" @releaseAssets --clobber 2>&1 | Out-Null
         gh release edit "v$Version" --draft=false 2>&1 | Out-Null
         $uploadResult = $LASTEXITCODE
         $ErrorActionPreference = "Stop"
@@ -225,7 +257,7 @@ $Message
         # Create new release with binary (published, not draft)
         Write-Host "      Creating new release..." -ForegroundColor Cyan
         $ErrorActionPreference = "SilentlyContinue"
-        gh release create "v$Version" $releaseFirmware --title "SmolTxt v$Version" --notes "$Message" --latest 2>&1 | Out-Null
+        gh release create "v$Version" @releaseAssets --title "SmolTxt v$Version" --notes "$Message" --latest 2>&1 | Out-Null
         $createResult = $LASTEXITCODE
         $ErrorActionPreference = "Stop"
         
@@ -1,14 +1,34 @@
 #include "Battery.h"
 #include <driver/adc.h>
-#include <esp_adc_cal.h>
 
-Battery::Battery() {
-    lastVoltage = 0.0;
-    lastPercent = 0;
-    lastReadTime = 0;
+// Single-cell LiPo open-circuit discharge curve, highest voltage first.
+// Percent is interpolated linearly between neighbouring points.
+struct DischargePoint {
+    uint16_t millivolts;
+    uint8_t percent;
+};
+
+static const DischargePoint DISCHARGE_CURVE[] = {
+    {4200, 100}, {4150, 95}, {4110, 90}, {4080, 85}, {4020, 80},
+    {3980, 75},  {3950, 70}, {3910, 65}, {3870, 60}, {3850, 55},
+    {3840, 50},  {3820, 45}, {3800, 40}, {3790, 35}, {3770, 30},
+    {3750, 25},  {3730, 20}, {3710, 15}, {3690, 10}, {3610, 5},
+    {3270, 0}
+};
+static const int DISCHARGE_POINTS = sizeof(DISCHARGE_CURVE) / sizeof(DISCHARGE_CURVE[0]);
+
+Battery::Battery() : millivolts(0), sampleMv(0), pinMv(0), percent(0) {
+    memset(&adcChars, 0, sizeof(adcChars));
+    average = 0.0;
+    sampler = nullptr;
+    lastLogTime = 0;
 }
 
 bool Battery::begin() {
+    if (sampler) {
+        return true;  // Already running (fast nap wake, then full boot)
+    }
+    
     // Configure ADC control pin
     pinMode(ADC_CTRL, OUTPUT);
     disableADC();  // Start with ADC disabled to save power
@@ -17,93 +37,134 @@ bool Battery::begin() {
     adc1_config_width(ADC_WIDTH_BIT_12);
     adc1_config_channel_atten(ADC_CHANNEL, ADC_ATTENUATION);
     
-    Serial.println("[Battery] Initialized");
+    esp_adc_cal_value_t calibration = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTENUATION, ADC_WIDTH_BIT_12,
+                                                               ADC_DEFAULT_VREF, &adcChars);
+    const char* source;
+    switch (calibration) {
+        case ESP_ADC_CAL_VAL_EFUSE_TP_FIT: source = "eFuse two-point fit"; break;  // ESP32-S3
+        case ESP_ADC_CAL_VAL_EFUSE_TP:     source = "eFuse two-point"; break;
+        case ESP_ADC_CAL_VAL_EFUSE_VREF:   source = "eFuse Vref"; break;
+        case ESP_ADC_CAL_VAL_DEFAULT_VREF: source = "default Vref"; break;
+        default:                           source = "unknown"; break;
+    }
+    Serial.println("[Battery] Initialized (ADC calibration: " + String(source) + ")");
     
-    // Take initial reading
-    update();
+    // Seed the average so boot-time checks see a real voltage
+    addSample(readMillivolts());
+    Serial.printf("[Battery] Voltage: %.2fV (pin %umV), Percent: %d%%\n", getVoltage(),
+                  (unsigned)pinMv.load(std::memory_order_relaxed), getPercent());
+    lastLogTime = millis();
+    
+    if (xTaskCreate(samplerTaskEntry, "battsense", 3072, this, 1, &sampler) != pdPASS) {
+        sampler = nullptr;
+        Serial.println("[Battery] Could not start sampler task - voltage will not update");
+        return false;
+    }
     
     return true;
 }
 
 void Battery::enableADC() {
     digitalWrite(ADC_CTRL, ADC_CTRL_ENABLED);
-    delay(10);  // Let voltage divider stabilize
 }
 
 void Battery::disableADC() {
     digitalWrite(ADC_CTRL, !ADC_CTRL_ENABLED);
 }
 
-float Battery::readRawVoltage() {
+uint32_t Battery::readMillivolts() {
     enableADC();
+    vTaskDelay(pdMS_TO_TICKS(BATTERY_SETTLE_MS));  // Let voltage divider stabilize
     
     uint32_t raw = 0;
     int validSamples = 0;
     
-    // Take multiple samples and average
+    // Back-to-back conversions - each takes microseconds, no need to space them out
     for (int i = 0; i < BATTERY_SENSE_SAMPLES; i++) {
         int reading = adc1_get_raw(ADC_CHANNEL);
         if (reading >= 0) {
             raw += reading;
             validSamples++;
         }
-        delay(1);
     }
     
     disableADC();
     
     if (validSamples == 0) {
         Serial.println("[Battery] No valid ADC readings");
-        return 0.0;
+        return 0;
     }
     
-    // Calculate average
-    raw = raw / validSamples;
+    // Calibrated pin voltage, then undo the voltage divider
+    uint32_t mv = esp_adc_cal_raw_to_voltage(raw / validSamples, &adcChars);
+    pinMv.store(mv, std::memory_order_relaxed);
+    return (uint32_t)(mv * ADC_MULTIPLIER);
+}
+
+void Battery::addSample(uint32_t mv) {
+    if (mv == 0) return;  // Failed read - keep the previous average
+    sampleMv.store(mv, std::memory_order_relaxed);
     
-    // Convert to voltage (12-bit ADC, 2.5dB attenuation range is ~0-1250mV)
-    // Reference voltage for ESP32-S3 with 2.5dB attenuation
-    float voltage = (raw / 4095.0) * 1.25;  // ADC reading to reference voltage
-    voltage *= ADC_MULTIPLIER;  // Apply voltage divider multiplier
+    // Start over on a step (charger connected or removed) instead of easing into it
+    if (average == 0.0 || fabsf((float)mv - average) >= BATTERY_JUMP_MV) {
+        average = mv;
+    } else {
+        average += BATTERY_EMA_WEIGHT * ((float)mv - average);
+    }
     
-    return voltage;
+    uint32_t smoothed = (uint32_t)(average + 0.5f);
+    millivolts.store(smoothed, std::memory_order_relaxed);
+    percent.store(voltageToPercent(smoothed), std::memory_order_relaxed);
 }
 
-int Battery::voltageToPercent(float voltage) {
-    // LiPo voltage curve (approximate)
-    // 4.2V = 100%, 3.7V = 50%, 3.3V = 0%
+int Battery::voltageToPercent(uint32_t mv) {
+    if (mv >= DISCHARGE_CURVE[0].millivolts) return 100;
+    if (mv <= DISCHARGE_CURVE[DISCHARGE_POINTS - 1].millivolts) return 0;
     
-    if (voltage >= 4.2) return 100;
-    if (voltage <= 3.3) return 0;
-    
-    // Linear approximation (can be improved with proper discharge curve)
-    if (voltage >= 3.7) {
-        // 3.7V to 4.2V = 50% to 100%
-        return 50 + (int)((voltage - 3.7) / 0.5 * 50);
-    } else {
-        // 3.3V to 3.7V = 0% to 50%
-        return (int)((voltage - 3.3) / 0.4 * 50);
+    for (int i = 1; i < DISCHARGE_POINTS; i++) {
+        const DischargePoint& upper = DISCHARGE_CURVE[i - 1];
+        const DischargePoint& lower = DISCHARGE_CURVE[i];
+        if (mv >= lower.millivolts) {
+            return lower.percent + (int)((mv - lower.millivolts) * (upper.percent - lower.percent) /
+                                         (upper.millivolts - lower.millivolts));
+        }
+    }
+    return 0;
+}
+
+void Battery::samplerTaskEntry(void* param) {
+    static_cast<Battery*>(param)->samplerLoop();
+}
+
+void Battery::samplerLoop() {
+    TickType_t lastWake = xTaskGetTickCount();
+    while (true) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(BATTERY_SAMPLE_INTERVAL));
+        addSample(readMillivolts());
     }
 }
 
 void Battery::update() {
-    // Rate limit readings to save power
-    if (millis() - lastReadTime < READ_INTERVAL && lastReadTime != 0) {
+    // Readings come from the sampler task - just keep the periodic log line
+    if (millis() - lastLogTime < BATTERY_LOG_INTERVAL) {
         return;
     }
     
-    lastReadTime = millis();
-    lastVoltage = readRawVoltage();
-    lastPercent = voltageToPercent(lastVoltage);
-    
-    Serial.printf("[Battery] Voltage: %.2fV, Percent: %d%%\n", lastVoltage, lastPercent);
+    lastLogTime = millis();
+    Serial.printf("[Battery] Voltage: %.2fV (pin %umV), Percent: %d%%\n", getVoltage(),
+                  (unsigned)pinMv.load(std::memory_order_relaxed), getPercent());
 }
 
 float Battery::getVoltage() {
-    return lastVoltage;
+    return millivolts.load(std::memory_order_relaxed) / 1000.0f;
+}
+
+float Battery::getSampleVoltage() {
+    return sampleMv.load(std::memory_order_relaxed) / 1000.0f;
 }
 
 int Battery::getPercent() {
-    return lastPercent;
+    return percent.load(std::memory_order_relaxed);
 }
 
 bool Battery::isCharging() {
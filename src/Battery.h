@@ -2,35 +2,63 @@
 #define BATTERY_H
 
 #include <Arduino.h>
+#include <atomic>
+#include <esp_adc_cal.h>
 
 // Heltec Vision Master E290 battery pins
 #define BATTERY_PIN 7
 #define ADC_CTRL 46
 #define ADC_CTRL_ENABLED HIGH
 #define ADC_CHANNEL ADC1_CHANNEL_6  // GPIO7 is ADC1 Channel 6 on ESP32-S3
-#define ADC_MULTIPLIER 5.265  // Calibrated: 5.047 * (4.07 / 3.9)
+// Applied to the calibrated pin voltage (mV): the 390k/100k divider ratio (4.9) with
+// the 4.5% trim used for this board with calibrated readings. The old multiplier
+// (5.265) was trimmed against the uncalibrated raw/4095*1.25 conversion and doesn't
+// carry over. Its meter point was 4.07V = raw ~2532 (773mV nominal); this value
+// expects ~795mV calibrated there. To re-trim: meter voltage / pin mV from the
+// [Battery] log line
+#define ADC_MULTIPLIER (4.9 * 1.045)
 #define ADC_ATTENUATION ADC_ATTEN_DB_2_5
+#define ADC_DEFAULT_VREF 1100  // mV, only used when the eFuse has no calibration
 #define BATTERY_SENSE_SAMPLES 10
+#define BATTERY_SETTLE_MS 10           // Voltage divider settling time after ADC_CTRL goes high
+#define BATTERY_SAMPLE_INTERVAL 5000   // Background sample period
+#define BATTERY_EMA_WEIGHT 0.25f       // Weight of each new sample - ~20s time constant
+#define BATTERY_JUMP_MV 150            // A sample this far off restarts the average (USB plugged/unplugged)
+#define BATTERY_LOG_INTERVAL 30000
 
+// Battery monitor. A low-priority background task enables the divider every
+// BATTERY_SAMPLE_INTERVAL, takes a burst of raw reads, converts them with the eFuse
+// ADC calibration and folds the result into an exponential moving average.
+// getVoltage()/getPercent() just load the latest average, so callers on the loop
+// task never wait on the ADC.
 class Battery {
 private:
-    float lastVoltage;
-    int lastPercent;
-    unsigned long lastReadTime;
-    static const unsigned long READ_INTERVAL = 30000;  // Read every 30 seconds
+    esp_adc_cal_characteristics_t adcChars;
+    std::atomic<uint32_t> millivolts;  // Smoothed battery voltage
+    std::atomic<uint32_t> sampleMv;    // Latest unsmoothed sample
+    std::atomic<uint32_t> pinMv;       // Latest calibrated pin voltage, for checking ADC_MULTIPLIER
+    std::atomic<int> percent;
+    float average;                     // EMA state - sampler task only
+    TaskHandle_t sampler;
+    unsigned long lastLogTime;
     
     void enableADC();
     void disableADC();
-    float readRawVoltage();
-    int voltageToPercent(float voltage);
+    uint32_t readMillivolts();
+    void addSample(uint32_t mv);
+    int voltageToPercent(uint32_t mv);
+    
+    static void samplerTaskEntry(void* param);
+    void samplerLoop();
     
 public:
     Battery();
     
-    bool begin();
-    void update();  // Call periodically to update readings
+    bool begin();   // Takes the first reading (blocks ~BATTERY_SETTLE_MS) and starts the sampler
+    void update();  // Call periodically - only logs, sampling runs in the background
     
     float getVoltage();  // Returns battery voltage in volts
+    float getSampleVoltage();  // Latest unsmoothed sample - reacts to USB within one sample period
     int getPercent();    // Returns battery percentage 0-100
     bool isCharging();   // Future: detect if charging
 };
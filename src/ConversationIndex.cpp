@@ -0,0 +1,277 @@
+#include "ConversationIndex.h"
+#include "Logger.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <algorithm>
+
+#define CONVERSATION_MANIFEST "/conversations.dat"
+
+ConversationIndex conversationIndex;
+
+ConversationIndex::ConversationIndex() {
+    memset(slots, 0, sizeof(slots));
+    loaded = false;
+    lock = nullptr;
+    dirty = false;
+    dirtySince = 0;
+}
+
+void ConversationIndex::begin() {
+    if (loaded) return;
+    if (!lock) lock = xSemaphoreCreateMutex();
+
+    if (!LittleFS.begin(true)) {
+        Serial.println("[Conversations] LittleFS unavailable - manifest disabled");
+        return;
+    }
+
+    if (!load()) {
+        Serial.println("[Conversations] No manifest - rebuilding from slot files");
+        rebuild();
+        save();
+    }
+    loaded = true;
+}
+
+bool ConversationIndex::load() {
+    File file = LittleFS.open(CONVERSATION_MANIFEST, "r");
+    if (!file) return false;
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        Serial.println("[Conversations] Manifest corrupted: " + String(error.c_str()));
+        return false;
+    }
+
+    memset(slots, 0, sizeof(slots));
+    for (JsonObject entry : doc["slots"].as<JsonArray>()) {
+        int slot = entry["slot"] | -1;
+        if (slot < 0 || slot >= MAX_CONVERSATION_SLOTS) continue;
+
+        SlotMeta& meta = slots[slot];
+        meta.used = true;
+        strncpy(meta.id, entry["id"] | "", sizeof(meta.id) - 1);
+        strncpy(meta.name, entry["name"] | "", sizeof(meta.name) - 1);
+        meta.lastActivity = entry["last"] | 0UL;
+        meta.unread = entry["unread"] | 0;
+        strncpy(meta.preview, entry["preview"] | "", sizeof(meta.preview) - 1);
+    }
+
+    Serial.println("[Conversations] Manifest loaded");
+    return true;
+}
+
+bool ConversationIndex::save() {
+    // Serialize from a snapshot so the MQTT task isn't held up by the flash write
+    take();
+    SlotMeta snapshot[MAX_CONVERSATION_SLOTS];
+    memcpy(snapshot, slots, sizeof(slots));
+    dirty = false;
+    give();
+
+    JsonDocument doc;
+    JsonArray arr = doc["slots"].to<JsonArray>();
+
+    for (int i = 0; i < MAX_CONVERSATION_SLOTS; i++) {
+        if (!snapshot[i].used) continue;
+        JsonObject entry = arr.add<JsonObject>();
+        entry["slot"] = i;
+        entry["id"] = snapshot[i].id;
+        entry["name"] = snapshot[i].name;
+        entry["last"] = snapshot[i].lastActivity;
+        entry["unread"] = snapshot[i].unread;
+        entry["preview"] = snapshot[i].preview;
+    }
+
+    File file = LittleFS.open(CONVERSATION_MANIFEST, "w");
+    if (!file) {
+        logger.error("Conversations: failed to write manifest");
+        return false;
+    }
+    serializeJson(doc, file);
+    file.close();
+    return true;
+}
+
+void ConversationIndex::markDirty() {
+    if (!dirty) {
+        dirty = true;
+        dirtySince = millis();
+    }
+}
+
+void ConversationIndex::update() {
+    take();
+    bool due = dirty && millis() - dirtySince >= CONVERSATION_FLUSH_DELAY;
+    give();
+    if (due) save();
+}
+
+void ConversationIndex::flush() {
+    take();
+    bool pending = dirty;
+    give();
+    if (pending) save();
+}
+
+void ConversationIndex::rebuild() {
+    memset(slots, 0, sizeof(slots));
+
+    for (int i = 0; i < MAX_CONVERSATION_SLOTS; i++) {
+        if (!Village::hasVillageInSlot(i)) continue;
+        slots[i].used = true;
+        strncpy(slots[i].id, Village::getVillageIdFromSlot(i).c_str(), sizeof(slots[i].id) - 1);
+        strncpy(slots[i].name, Village::getVillageNameFromSlot(i).c_str(), sizeof(slots[i].name) - 1);
+    }
+
+    // Single pass over the message store for last activity and preview
+    File file = LittleFS.open("/messages.dat", "r");
+    if (!file) return;
+
+    JsonDocument filter;
+    filter["village"] = true;
+    filter["timestamp"] = true;
+    filter["content"] = true;
+
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        line.trim();
+        if (line.length() == 0) continue;
+
+        JsonDocument doc;
+        if (deserializeJson(doc, line, DeserializationOption::Filter(filter))) continue;
+
+        int slot = findSlot(doc["village"] | "");
+        if (slot < 0) continue;
+
+        unsigned long timestamp = doc["timestamp"] | 0UL;
+        if (timestamp >= slots[slot].lastActivity) {
+            slots[slot].lastActivity = timestamp;
+            copyPreview(slots[slot].preview, doc["content"] | "");
+        }
+    }
+    file.close();
+}
+
+int ConversationIndex::findSlot(const String& villageId) {
+    if (villageId.isEmpty()) return -1;
+    for (int i = 0; i < MAX_CONVERSATION_SLOTS; i++) {
+        if (slots[i].used && villageId == slots[i].id) return i;
+    }
+    return -1;
+}
+
+void ConversationIndex::copyPreview(char* dest, const String& content) {
+    strncpy(dest, content.c_str(), CONVERSATION_PREVIEW_LEN - 1);
+    dest[CONVERSATION_PREVIEW_LEN - 1] = '\0';
+}
+
+void ConversationIndex::updateSlot(int slot, const String& villageId, const String& villageName) {
+    if (slot < 0 || slot >= MAX_CONVERSATION_SLOTS) return;
+
+    take();
+    SlotMeta& meta = slots[slot];
+    if (meta.used && villageId != meta.id) {
+        // Slot reused for a different village - activity doesn't carry over
+        memset(&meta, 0, sizeof(meta));
+    }
+
+    meta.used = true;
+    strncpy(meta.id, villageId.c_str(), sizeof(meta.id) - 1);
+    meta.id[sizeof(meta.id) - 1] = '\0';
+    strncpy(meta.name, villageName.c_str(), sizeof(meta.name) - 1);
+    meta.name[sizeof(meta.name) - 1] = '\0';
+    give();
+    save();
+}
+
+void ConversationIndex::removeSlot(int slot) {
+    if (slot < 0 || slot >= MAX_CONVERSATION_SLOTS) return;
+
+    take();
+    bool used = slots[slot].used;
+    memset(&slots[slot], 0, sizeof(SlotMeta));
+    give();
+    if (used) save();
+}
+
+void ConversationIndex::recordMessage(const String& villageId, const Message& msg) {
+    take();
+    int slot = findSlot(villageId);
+    if (slot < 0) {
+        give();
+        return;
+    }
+
+    SlotMeta& meta = slots[slot];
+
+    // Only messages newer than what we've seen count - synced history doesn't
+    // move the conversation up the list or light up the unread badge
+    if (msg.timestamp >= meta.lastActivity) {
+        if (msg.received && viewingVillageId != villageId && msg.timestamp > meta.lastActivity) {
+            meta.unread++;
+        }
+        meta.lastActivity = msg.timestamp;
+        copyPreview(meta.preview, msg.content);
+        markDirty();
+    }
+    give();
+}
+
+void ConversationIndex::setViewing(const String& villageId) {
+    take();
+    viewingVillageId = villageId;
+
+    int slot = findSlot(villageId);
+    if (slot >= 0 && slots[slot].unread > 0) {
+        slots[slot].unread = 0;
+        markDirty();
+    }
+    give();
+}
+
+int ConversationIndex::getTotalUnread() {
+    int total = 0;
+    take();
+    for (int i = 0; i < MAX_CONVERSATION_SLOTS; i++) {
+        if (slots[i].used) total += slots[i].unread;
+    }
+    give();
+    return total;
+}
+
+unsigned long ConversationIndex::getLastActivity(int slot) {
+    if (slot < 0 || slot >= MAX_CONVERSATION_SLOTS) return 0;
+    take();
+    unsigned long last = slots[slot].used ? slots[slot].lastActivity : 0;
+    give();
+    return last;
+}
+
+std::vector<ConversationEntry> ConversationIndex::getConversations() {
+    std::vector<ConversationEntry> list;
+
+    take();
+    for (int i = 0; i < MAX_CONVERSATION_SLOTS; i++) {
+        if (!slots[i].used) continue;
+        ConversationEntry entry;
+        entry.slot = i;
+        entry.name = slots[i].name;
+        entry.id = slots[i].id;
+        entry.lastActivity = slots[i].lastActivity;
+        entry.unreadCount = slots[i].unread;
+        entry.preview = slots[i].preview;
+        list.push_back(entry);
+    }
+    give();
+
+    // Most recent activity first, slot order for ties
+    std::stable_sort(list.begin(), list.end(), [](const ConversationEntry& a, const ConversationEntry& b) {
+        return a.lastActivity > b.lastActivity;
+    });
+
+    return list;
+}
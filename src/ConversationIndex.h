@@ -0,0 +1,80 @@
+#ifndef CONVERSATION_INDEX_H
+#define CONVERSATION_INDEX_H
+
+#include <Arduino.h>
+#include <vector>
+#include "Messages.h"
+#include "Village.h"
+
+#define MAX_CONVERSATION_SLOTS MAX_VILLAGE_SLOTS
+#define CONVERSATION_PREVIEW_LEN 48
+#define CONVERSATION_FLUSH_DELAY 3000  // Message activity is batched this long before a write
+
+// One row of the "My Conversations" list
+struct ConversationEntry {
+    int slot;
+    String name;
+    String id;
+    unsigned long lastActivity;  // Timestamp of most recent message
+    int unreadCount;
+    String preview;              // Start of the most recent message
+};
+
+// Small manifest (/conversations.dat) with per-slot metadata for the conversation list.
+// Kept up to date incrementally as slots and messages are saved, so the list renders
+// from one small read instead of opening and parsing every slot file.
+//
+// recordMessage() runs on the ESP-MQTT task, the list is read on the loop task - the
+// in-memory table is guarded by a mutex. Message activity only marks the manifest dirty;
+// update() writes it once CONVERSATION_FLUSH_DELAY has passed, so a sync burst costs one
+// write. Call flush() before deep sleep. Slot changes are written immediately.
+class ConversationIndex {
+private:
+    struct SlotMeta {
+        bool used;
+        char id[37];
+        char name[MAX_VILLAGE_NAME];
+        unsigned long lastActivity;
+        uint16_t unread;
+        char preview[CONVERSATION_PREVIEW_LEN];
+    };
+
+    SlotMeta slots[MAX_CONVERSATION_SLOTS];
+    bool loaded;
+    String viewingVillageId;  // Conversation on screen - its messages don't count as unread
+    SemaphoreHandle_t lock;   // Guards slots[], viewingVillageId and the dirty state
+    bool dirty;
+    unsigned long dirtySince;
+
+    bool load();
+    bool save();
+    void markDirty();  // Caller holds lock
+    void take() { if (lock) xSemaphoreTake(lock, portMAX_DELAY); }
+    void give() { if (lock) xSemaphoreGive(lock); }
+    void rebuild();  // One-time migration when no manifest exists yet
+    int findSlot(const String& villageId);
+    static void copyPreview(char* dest, const String& content);
+
+public:
+    ConversationIndex();
+
+    void begin();  // Load manifest once at boot
+    void update();  // Loop task - writes pending activity once the flush delay has passed
+    void flush();   // Write pending activity now (before deep sleep)
+
+    // Slot lifecycle (create/join/rename/delete)
+    void updateSlot(int slot, const String& villageId, const String& villageName);
+    void removeSlot(int slot);
+
+    // Message activity - called from the message save paths
+    void recordMessage(const String& villageId, const Message& msg);
+    void setViewing(const String& villageId);  // Empty = no conversation open; clears unread
+
+    int getTotalUnread();
+    unsigned long getLastActivity(int slot);
+    std::vector<ConversationEntry> getConversations();  // Most recent activity first
+};
+
+extern ConversationIndex conversationIndex;
+
+#endif
@@ -0,0 +1,311 @@
+#include "DeltaPatcher.h"
+#include <Update.h>
+#include <esp_ota_ops.h>
+
+static int32_t readInt32(const uint8_t* p) {
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+DeltaPatcher::DeltaPatcher() {
+    phase = PATCH_HEADER;
+    headerFill = 0;
+    oldSize = 0;
+    newSize = 0;
+    controlFill = 0;
+    addLeft = 0;
+    copyLeft = 0;
+    seek = 0;
+    base = nullptr;
+    oldPos = 0;
+    oldCache = nullptr;
+    oldCacheStart = 0;
+    oldCacheLen = 0;
+    outBuffer = nullptr;
+    outFill = 0;
+    newWritten = 0;
+    inflator = nullptr;
+    dict = nullptr;
+    dictOffset = 0;
+    inflateDone = false;
+    mbedtls_sha256_init(&newHash);
+}
+
+DeltaPatcher::~DeltaPatcher() {
+    abort();
+}
+
+bool DeltaPatcher::fail(const String& reason) {
+    if (phase != PATCH_FAILED) {
+        error = reason;
+        Serial.println("[Delta] Failed: " + reason);
+    }
+    phase = PATCH_FAILED;
+    return false;
+}
+
+void DeltaPatcher::release() {
+    free(oldCache);
+    free(outBuffer);
+    free(inflator);
+    free(dict);
+    oldCache = nullptr;
+    outBuffer = nullptr;
+    inflator = nullptr;
+    dict = nullptr;
+    mbedtls_sha256_free(&newHash);
+}
+
+void DeltaPatcher::abort() {
+    if (Update.isRunning()) {
+        Update.abort();
+    }
+    release();
+    if (phase != PATCH_DONE) phase = PATCH_FAILED;
+}
+
+bool DeltaPatcher::write(const uint8_t* data, size_t len) {
+    if (phase == PATCH_FAILED) return false;
+
+    // Header arrives first, uncompressed
+    while (phase == PATCH_HEADER && len > 0) {
+        size_t n = min(len, (size_t)(DELTA_HEADER_SIZE - headerFill));
+        memcpy(header + headerFill, data, n);
+        headerFill += n;
+        data += n;
+        len -= n;
+
+        if (headerFill == DELTA_HEADER_SIZE && !startPatch()) {
+            return false;
+        }
+    }
+
+    if (len == 0) return true;
+    return inflate(data, len);
+}
+
+bool DeltaPatcher::startPatch() {
+    if (memcmp(header, DELTA_MAGIC, 8) != 0) {
+        return fail("bad patch magic");
+    }
+    oldSize = (uint32_t)readInt32(header + 8);
+    newSize = (uint32_t)readInt32(header + 12);
+    memcpy(expectedHash, header + 48, 32);
+
+    base = esp_ota_get_running_partition();
+    if (!base || oldSize == 0 || oldSize > base->size) {
+        return fail("patch base larger than running partition");
+    }
+
+    oldCache = (uint8_t*)malloc(DELTA_OLD_CACHE);
+    outBuffer = (uint8_t*)malloc(DELTA_OUT_BUFFER);
+    inflator = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+    dict = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+    if (!oldCache || !outBuffer || !inflator || !dict) {
+        return fail("out of memory");
+    }
+
+    // A patch only applies to the exact image it was built against
+    if (!verifyBase()) {
+        return fail("patch was built for a different firmware");
+    }
+
+    if (!Update.begin(newSize)) {
+        return fail("Update.begin: " + String(Update.errorString()));
+    }
+
+    tinfl_init(inflator);
+    mbedtls_sha256_starts(&newHash, 0);
+    Serial.println("[Delta] Applying patch: " + String(oldSize) + " -> " + String(newSize) + " bytes");
+    phase = PATCH_CONTROL;
+    return true;
+}
+
+bool DeltaPatcher::verifyBase() {
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+
+    for (uint32_t pos = 0; pos < oldSize; pos += DELTA_OLD_CACHE) {
+        uint32_t n = min((uint32_t)DELTA_OLD_CACHE, oldSize - pos);
+        if (esp_partition_read(base, pos, oldCache, n) != ESP_OK) {
+            mbedtls_sha256_free(&ctx);
+            return false;
+        }
+        mbedtls_sha256_update(&ctx, oldCache, n);
+    }
+
+    uint8_t hash[32];
+    mbedtls_sha256_finish(&ctx, hash);
+    mbedtls_sha256_free(&ctx);
+    oldCacheLen = 0;  // Cache held hashing scratch, not a window
+    return memcmp(hash, header + 16, 32) == 0;
+}
+
+bool DeltaPatcher::inflate(const uint8_t* data, size_t len) {
+    if (inflateDone) {
+        return fail("data after end of patch");
+    }
+
+    const mz_uint32 flags = TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT;
+    tinfl_status status = TINFL_STATUS_NEEDS_MORE_INPUT;
+
+    while (len > 0 || status == TINFL_STATUS_HAS_MORE_OUTPUT) {
+        size_t inBytes = len;
+        size_t outBytes = TINFL_LZ_DICT_SIZE - dictOffset;
+        status = tinfl_decompress(inflator, data, &inBytes, dict, dict + dictOffset, &outBytes, flags);
+        data += inBytes;
+        len -= inBytes;
+
+        if (outBytes > 0 && !consume(dict + dictOffset, outBytes)) {
+            return false;
+        }
+        dictOffset = (dictOffset + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status < 0) {
+            return fail("corrupt patch stream");
+        }
+        if (status == TINFL_STATUS_DONE) {
+            inflateDone = true;
+            return len == 0 || fail("data after end of patch");
+        }
+    }
+    return true;
+}
+
+bool DeltaPatcher::consume(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        switch (phase) {
+            case PATCH_CONTROL: {
+                size_t n = min(len, (size_t)(DELTA_CONTROL_SIZE - controlFill));
+                memcpy(control + controlFill, data, n);
+                controlFill += n;
+                data += n;
+                len -= n;
+                if (controlFill < DELTA_CONTROL_SIZE) break;
+
+                controlFill = 0;
+                addLeft = readInt32(control);
+                copyLeft = readInt32(control + 4);
+                seek = readInt32(control + 8);
+                if (addLeft < 0 || copyLeft < 0 ||
+                    (uint64_t)newWritten + addLeft + copyLeft > newSize ||
+                    (uint64_t)oldPos + addLeft > oldSize) {
+                    return fail("bad patch record");
+                }
+                phase = PATCH_ADD;
+                break;
+            }
+
+            case PATCH_ADD: {
+                size_t n = min(len, (size_t)addLeft);
+                for (size_t i = 0; i < n; i++) {
+                    uint8_t old;
+                    if (!readOld(oldPos++, old) || !emit(data[i] + old)) return false;
+                }
+                data += n;
+                len -= n;
+                addLeft -= n;
+                break;
+            }
+
+            case PATCH_COPY: {
+                size_t n = min(len, (size_t)copyLeft);
+                for (size_t i = 0; i < n; i++) {
+                    if (!emit(data[i])) return false;
+                }
+                data += n;
+                len -= n;
+                copyLeft -= n;
+                break;
+            }
+
+            case PATCH_DONE:
+                return fail("data after end of patch");
+
+            default:
+                return false;
+        }
+
+        // Record boundaries - also reached for zero-length add/copy sections
+        if (phase == PATCH_ADD && addLeft == 0) {
+            phase = PATCH_COPY;
+        }
+        if (phase == PATCH_COPY && copyLeft == 0) {
+            int64_t next = (int64_t)oldPos + seek;
+            if (next < 0 || next > oldSize) {
+                return fail("bad patch seek");
+            }
+            oldPos = (uint32_t)next;
+            phase = (newWritten == newSize) ? PATCH_DONE : PATCH_CONTROL;
+        }
+    }
+    return true;
+}
+
+bool DeltaPatcher::readOld(uint32_t pos, uint8_t& value) {
+    if (pos < oldCacheStart || pos >= oldCacheStart + oldCacheLen) {
+        oldCacheStart = pos;
+        oldCacheLen = min((uint32_t)DELTA_OLD_CACHE, oldSize - pos);
+        if (esp_partition_read(base, pos, oldCache, oldCacheLen) != ESP_OK) {
+            oldCacheLen = 0;
+            return fail("flash read failed");
+        }
+    }
+    value = oldCache[pos - oldCacheStart];
+    return true;
+}
+
+bool DeltaPatcher::emit(uint8_t value) {
+    outBuffer[outFill++] = value;
+    newWritten++;
+    if (outFill == DELTA_OUT_BUFFER) {
+        return flushOut();
+    }
+    return true;
+}
+
+bool DeltaPatcher::flushOut() {
+    if (outFill == 0) return true;
+
+    mbedtls_sha256_update(&newHash, outBuffer, outFill);
+    if (Update.write(outBuffer, outFill) != outFill) {
+        return fail("Update.write: " + String(Update.errorString()));
+    }
+    outFill = 0;
+    return true;
+}
+
+bool DeltaPatcher::finish() {
+    if (phase == PATCH_FAILED) {
+        abort();
+        return false;
+    }
+    if (phase != PATCH_DONE || !inflateDone || newWritten != newSize) {
+        fail("patch truncated (" + String(newWritten) + "/" + String(newSize) + " bytes)");
+        abort();
+        return false;
+    }
+    if (!flushOut()) {
+        abort();
+        return false;
+    }
+
+    uint8_t hash[32];
+    mbedtls_sha256_finish(&newHash, hash);
+    if (memcmp(hash, expectedHash, 32) != 0) {
+        fail("hash mismatch on patched image");
+        abort();
+        return false;
+    }
+
+    // Hash checked - only now make the new slot bootable
+    if (!Update.end(true)) {
+        fail("Update.end: " + String(Update.errorString()));
+        abort();
+        return false;
+    }
+
+    release();
+    Serial.println("[Delta] Patched image verified (" + String(newSize) + " bytes)");
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef DELTA_PATCHER_H
+#define DELTA_PATCHER_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+
+#if CONFIG_IDF_TARGET_ESP32S3
+#include <esp32s3/rom/miniz.h>
+#else
+#include <esp32/rom/miniz.h>
+#endif
+
+// Delta OTA patch, as produced by tools/make_delta.py:
+//
+//   header (80 bytes, uncompressed)
+//     magic "SMOLDLT1" | oldSize u32 | newSize u32 | sha256(old) | sha256(new)
+//   body (one zlib stream) - bsdiff-style records until newSize bytes are produced:
+//     addLen i32 | copyLen i32 | seek i32        (little-endian)
+//     addLen bytes  - added bytewise to the old image at the old cursor
+//     copyLen bytes - inserted verbatim
+//     then the old cursor moves by seek
+//
+// Most of a point release is code that moved by a few bytes, so the add bytes are
+// nearly all zero and the compressed patch is a small fraction of firmware.bin.
+#define DELTA_MAGIC "SMOLDLT1"
+#define DELTA_HEADER_SIZE 80
+#define DELTA_CONTROL_SIZE 12
+#define DELTA_OLD_CACHE 4096     // Window over the running partition
+#define DELTA_OUT_BUFFER 4096    // Bytes batched per Update.write()
+
+// Streams a patch into the inactive OTA slot: the old image is read from the running
+// partition, the result goes through Update and is verified against the header hash
+// before the slot is marked bootable. Feed it raw patch bytes as they arrive.
+class DeltaPatcher {
+private:
+    enum Phase {
+        PATCH_HEADER,
+        PATCH_CONTROL,
+        PATCH_ADD,
+        PATCH_COPY,
+        PATCH_DONE,
+        PATCH_FAILED
+    };
+
+    Phase phase;
+    String error;
+
+    uint8_t header[DELTA_HEADER_SIZE];
+    size_t headerFill;
+    uint32_t oldSize;
+    uint32_t newSize;
+    uint8_t expectedHash[32];
+
+    uint8_t control[DELTA_CONTROL_SIZE];
+    size_t controlFill;
+    int32_t addLeft;
+    int32_t copyLeft;
+    int32_t seek;
+
+    const esp_partition_t* base;
+    uint32_t oldPos;
+    uint8_t* oldCache;
+    uint32_t oldCacheStart;
+    uint32_t oldCacheLen;
+
+    uint8_t* outBuffer;
+    size_t outFill;
+    uint32_t newWritten;
+    mbedtls_sha256_context newHash;
+
+    tinfl_decompressor* inflator;
+    uint8_t* dict;               // TINFL_LZ_DICT_SIZE ring for the inflater output
+    size_t dictOffset;
+    bool inflateDone;
+
+    bool startPatch();
+    bool verifyBase();
+    bool inflate(const uint8_t* data, size_t len);
+    bool consume(const uint8_t* data, size_t len);
+    bool readOld(uint32_t pos, uint8_t& value);
+    bool emit(uint8_t value);
+    bool flushOut();
+    bool fail(const String& reason);
+    void release();
+
+public:
+    DeltaPatcher();
+    ~DeltaPatcher();
+
+    bool write(const uint8_t* data, size_t len);  // Raw patch bytes, in order
+    bool finish();                                // Verify and commit - true = reboot into it
+    void abort();
+
+    uint32_t getNewSize() const { return newSize; }
+    uint32_t getBytesWritten() const { return newWritten; }
+    const String& getError() const { return error; }
+};
+
+#endif
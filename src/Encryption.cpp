@@ -1,4 +1,5 @@
 #include "Encryption.h"
+#include "Metrics.h"
 #include <RNG.h>
 #include <string.h>
 
@@ -20,6 +21,8 @@ void Encryption::generateNonce(uint8_t* nonce) {
 
 int Encryption::encrypt(const uint8_t* plaintext, size_t plaintextLen, 
                         uint8_t* output, size_t outputMaxLen) {
+    MetricTimer timer(HIST_ENCRYPT);
+    
     if (plaintextLen > MAX_PLAINTEXT) {
         return 0;  // Message too long
     }
@@ -68,6 +71,8 @@ int Encryption::encrypt(const uint8_t* plaintext, size_t plaintextLen,
 
 int Encryption::decrypt(const uint8_t* input, size_t inputLen,
                         uint8_t* output, size_t outputMaxLen) {
+    MetricTimer timer(HIST_DECRYPT);
+    
     if (inputLen < NONCE_SIZE + TAG_SIZE) {
         return -1;  // Invalid input
     }
@@ -0,0 +1,69 @@
+#ifndef KEY_EVENT_QUEUE_H
+#define KEY_EVENT_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+#define KEY_QUEUE_SIZE 64  // Power of two - indices wrap with a mask
+
+// KeyEvent modifier flags (set by Keyboard::pushKey, acted on in Keyboard::update)
+#define KEY_MOD_REPEAT 0x01  // Same key again within KEY_REPEAT_MS (held / auto-repeat) -
+                             // a stale repeat of a navigation key is skipped
+#define KEY_MOD_SERIAL 0x02  // From the Serial fallback, not the CardKB - never debounced
+
+#define KEY_REPEAT_MS 250
+
+struct KeyEvent {
+    char key;
+    uint8_t modifiers;
+    uint32_t timestampUs;  // micros() when read from the hardware
+};
+
+// Lock-free single-producer/single-consumer ring of key events.
+// The producer is whoever reads the CardKB (the interrupt reader task, or update()
+// when polling); the consumer is Keyboard::update() on the loop task. The indices
+// are free-running atomics - the producer publishes a slot with a release store of
+// head, the consumer frees it with a release store of tail - so it is safe across
+// cores and from ISR context without a lock.
+class KeyEventQueue {
+private:
+    KeyEvent events[KEY_QUEUE_SIZE];
+    std::atomic<uint32_t> head;  // Next slot to write (producer)
+    std::atomic<uint32_t> tail;  // Next slot to read (consumer)
+
+public:
+    KeyEventQueue() : head(0), tail(0) {}
+
+    // Producer side. False = full, event dropped
+    bool push(const KeyEvent& event) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= KEY_QUEUE_SIZE) {
+            return false;
+        }
+        events[h & (KEY_QUEUE_SIZE - 1)] = event;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(KeyEvent& event) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        event = events[t & (KEY_QUEUE_SIZE - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const {
+        return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+    }
+
+    // Consumer side - discard everything queued so far
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "Keyboard.h"
+#include "Metrics.h"
 
 #define KEY_DEBOUNCE_MS 30  // Minimal debounce - just catch electrical bounce
 
@@ -7,14 +8,21 @@ Keyboard::Keyboard(TwoWire* w, uint8_t addr) {
     i2cAddress = addr;
     inputBuffer = "";
     lastKey = 0;
+    lastKeyUs = 0;
     currentKey = 0;
-    lastKeyTime = 0;
+    currentKeyUs = 0;
+    currentKeySeq = 0;
     keyboardPresent = false;  // Will check on begin()
-    bufferHead = 0;
-    bufferTail = 0;
+    lastPushedKey = 0;
+    lastPushedUs = 0;
     lastRawKey = 0;
     sameKeyCount = 0;
-    memset(keyBuffer, 0, KEY_BUFFER_SIZE);
+    keyCount = 0;
+#ifdef KEYBOARD_USE_INTERRUPT
+    intPin = GPIO_NUM_NC;
+    readerTask = nullptr;
+    keyCallback = nullptr;
+#endif
 }
 
 bool Keyboard::begin() {
@@ -23,13 +31,11 @@ bool Keyboard::begin() {
     // Clear all state to prevent phantom key presses from garbage data
     inputBuffer = "";
     lastKey = 0;
+    lastKeyUs = 0;
     currentKey = 0;
-    lastKeyTime = 0;
-    bufferHead = 0;
-    bufferTail = 0;
+    events.clear();
     lastRawKey = 0;
     sameKeyCount = 0;
-    memset(keyBuffer, 0, KEY_BUFFER_SIZE);
     Serial.println("[Keyboard] State cleared: currentKey=0, inputBuffer empty");
     
     // Try to detect keyboard with retry logic for reliability
@@ -72,13 +78,16 @@ bool Keyboard::begin() {
     return false;  // Will use Serial as fallback
 }
 
-char Keyboard::readKey() {
+char Keyboard::readKey(uint8_t& modifiers) {
     static uint32_t readCounter = 0;
     
+    modifiers = 0;
+    
     // Only try I2C if keyboard is present
     if (!keyboardPresent) {
         // Fallback to Serial for testing
         if (Serial.available()) {
+            modifiers = KEY_MOD_SERIAL;
             return Serial.read();
         }
         return 0;
@@ -147,6 +156,7 @@ char Keyboard::readKey() {
     
     // Fallback to Serial for testing
     if (Serial.available()) {
+        modifiers = KEY_MOD_SERIAL;
         return Serial.read();
     }
     
@@ -157,58 +167,140 @@ bool Keyboard::isKeyboardPresent() {
     return keyboardPresent;
 }
 
-void Keyboard::bufferKey(char key) {
-    uint8_t nextHead = (bufferHead + 1) % KEY_BUFFER_SIZE;
-    if (nextHead != bufferTail) {  // Buffer not full
-        keyBuffer[bufferHead] = key;
-        bufferHead = nextHead;
+void Keyboard::pushKey(char key, uint8_t modifiers) {
+    uint32_t now = micros();
+    if (key == lastPushedKey && now - lastPushedUs < KEY_REPEAT_MS * 1000UL) {
+        modifiers |= KEY_MOD_REPEAT;
+    }
+    lastPushedKey = key;
+    lastPushedUs = now;
+    
+    if (!events.push({ key, modifiers, now })) {
+        metrics.increment(CTR_KEYS_DROPPED);
     }
 }
 
-char Keyboard::getBufferedKey() {
-    if (bufferHead == bufferTail) {
-        return 0;  // Buffer empty
+#ifdef KEYBOARD_USE_INTERRUPT
+bool Keyboard::beginInterrupt(uint8_t pin, void (*onKey)()) {
+    if (!keyboardPresent || readerTask) return false;
+    
+    intPin = (gpio_num_t)pin;
+    keyCallback = onKey;
+    
+    // Same core as loop() - not required by the queue, but keeps the hand-off cheap
+    if (xTaskCreatePinnedToCore(readerTaskEntry, "kbread", 3072, this, 3, &readerTask, ARDUINO_RUNNING_CORE) != pdPASS) {
+        readerTask = nullptr;
+        return false;
     }
-    char key = keyBuffer[bufferTail];
-    bufferTail = (bufferTail + 1) % KEY_BUFFER_SIZE;
-    return key;
+    
+    // Level-triggered: also what light-sleep GPIO wake uses, so the two share the pin config
+    gpio_install_isr_service(0);  // Already installed by the core is fine
+    gpio_set_intr_type(intPin, GPIO_INTR_LOW_LEVEL);
+    if (gpio_isr_handler_add(intPin, onInterrupt, this) != ESP_OK) {
+        vTaskDelete(readerTask);
+        readerTask = nullptr;
+        return false;
+    }
+    gpio_intr_enable(intPin);
+    
+    Serial.println("[Keyboard] Interrupt-driven input on GPIO " + String(pin));
+    return true;
 }
 
-bool Keyboard::hasBufferedKeys() {
-    return bufferHead != bufferTail;
+void IRAM_ATTR Keyboard::onInterrupt(void* arg) {
+    Keyboard* self = static_cast<Keyboard*>(arg);
+    // One wake-up per press: the reader re-enables once it has drained the CardKB
+    gpio_intr_disable(self->intPin);
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->readerTask, &woken);
+    if (woken) portYIELD_FROM_ISR();
 }
 
+void Keyboard::readerTaskEntry(void* param) {
+    static_cast<Keyboard*>(param)->readerLoop();
+}
+
+void Keyboard::readerLoop() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        // Our own I2C reads toggle the line too - the interrupt stays off until done
+        bool gotKey = false;
+        for (int i = 0; i < KEYBOARD_DRAIN_MAX; i++) {
+            uint8_t modifiers;
+            char key = readKey(modifiers);
+            if (key == 0) break;
+            pushKey(key, modifiers);
+            gotKey = true;
+        }
+        
+        if (gotKey && keyCallback) {
+            keyCallback();
+        }
+        
+        // Held key keeps INT low - check again shortly instead of re-triggering at once
+        if (gpio_get_level(intPin) == 0) {
+            vTaskDelay(pdMS_TO_TICKS(KEYBOARD_HOLD_POLL_MS));
+        }
+        gpio_intr_enable(intPin);
+    }
+}
+#endif
+
 void Keyboard::update() {
     // First, read any new keys from hardware and buffer them
-    char key = readKey();
-    if (key != 0) {
-        bufferKey(key);
+    // (interrupt mode: the reader task already did)
+    if (!isInterruptDriven()) {
+        uint8_t modifiers;
+        char key = readKey(modifiers);
+        if (key != 0) {
+            pushKey(key, modifiers);
+        }
     }
     
-    // Clear debounce after timeout to allow same key to be pressed again
-    unsigned long currentTime = millis();
-    if (lastKey != 0 && (currentTime - lastKeyTime) >= KEY_DEBOUNCE_MS) {
-        lastKey = 0;
+    // A special key still waiting for its handler holds the queue, so quick presses
+    // are handled one by one instead of overwriting each other. Tab is a held state
+    // (see isTabHeld), not a press, and never blocks
+    if (currentKey != 0 && currentKey != CARDKB_TAB) {
+        return;
     }
     
-    // Now process buffered keys with debouncing
-    if (!hasBufferedKeys()) {
+    // Now process queued keys with debouncing
+    KeyEvent event;
+    if (!events.pop(event)) {
         return;
     }
     
-    key = getBufferedKey();
+    char key = event.key;
     
     if (key != 0) {
-        // Debounce: only reject if SAME key within debounce window
-        if (key == lastKey && (currentTime - lastKeyTime) < KEY_DEBOUNCE_MS) {
+        // Debounce: only reject if SAME key within debounce window (by read time,
+        // so time spent in the queue doesn't count). Serial input has no contacts to
+        // bounce - pasted text legitimately repeats characters back to back
+        if (!(event.modifiers & KEY_MOD_SERIAL) && key == lastKey &&
+            (event.timestampUs - lastKeyUs) < KEY_DEBOUNCE_MS * 1000UL) {
+            return;
+        }
+        
+        // A held arrow/enter/backspace auto-repeats. Repeats that sat in the queue past
+        // the repeat interval mean the handler fell behind - replaying that backlog
+        // would keep scrolling (or deleting) after the key was released. Printable
+        // repeats are kept: "ll" typed quickly is two real presses
+        bool printable = key >= 32 && key <= 126;
+        if ((event.modifiers & KEY_MOD_REPEAT) && !printable && key != CARDKB_TAB &&
+            micros() - event.timestampUs > KEY_REPEAT_MS * 1000UL) {
+            metrics.increment(CTR_KEYS_STALE_REPEAT);
             return;
         }
         
         lastKey = key;
-        lastKeyTime = currentTime;
+        lastKeyUs = event.timestampUs;
+        keyCount++;
         
         // Store current key for special key checks
         currentKey = key;
+        currentKeyUs = event.timestampUs;
+        currentKeySeq = keyCount;
         
         // Handle special keys that don't go into buffer
         if (key == '\n' || key == '\r' || key == 0xB2 || key == 0x0D) {
@@ -247,6 +339,7 @@ void Keyboard::update() {
         } else if (key >= 32 && key <= 126) {
             // Printable ASCII character - add to buffer
             inputBuffer += key;
+            consumed(event.timestampUs);
             currentKey = 0;  // Clear immediately - printable chars handled via inputBuffer
         } else {
             // Unrecognized key - log it
@@ -257,6 +350,27 @@ void Keyboard::update() {
     // Special keys (enter, arrows, backspace) remain in currentKey until explicitly consumed
 }
 
+bool Keyboard::takeKey(bool pressed) {
+    if (pressed) {
+        consumed(currentKeyUs);
+        currentKey = 0;  // Consume the key
+    }
+    return pressed;
+}
+
+void Keyboard::consumed(uint32_t keyUs) {
+    metrics.record(HIST_KEY_QUEUE, micros() - keyUs);
+    metrics.markInput(keyUs);
+}
+
+void Keyboard::dropUnhandledKey(uint32_t keyCountBefore) {
+    if (currentKey != 0 && currentKey != CARDKB_TAB && currentKeySeq <= keyCountBefore) {
+        Serial.printf("[Keyboard] Key 0x%02X not handled - dropped\n", (uint8_t)currentKey);
+        metrics.increment(CTR_KEYS_UNHANDLED);
+        currentKey = 0;
+    }
+}
+
 bool Keyboard::hasInput() {
     return inputBuffer.length() > 0;
 }
@@ -268,23 +382,19 @@ String Keyboard::getInput() {
 }
 
 void Keyboard::clearInput() {
+    // Stray keys live in the event queue and currentKey too, not just the text buffer.
+    // Consumer side - loop task only
     inputBuffer = "";
+    events.clear();
+    currentKey = 0;
 }
 
 bool Keyboard::isEnterPressed() {
-    bool pressed = (currentKey == '\n' || currentKey == '\r' || currentKey == CARDKB_ENTER);
-    if (pressed) {
-        currentKey = 0;  // Consume the key
-    }
-    return pressed;
+    return takeKey(currentKey == '\n' || currentKey == '\r' || currentKey == CARDKB_ENTER);
 }
 
 bool Keyboard::isBackspacePressed() {
-    bool pressed = (currentKey == 8 || currentKey == 127 || currentKey == CARDKB_BS);
-    if (pressed) {
-        currentKey = 0;  // Consume the key
-    }
-    return pressed;
+    return takeKey(currentKey == 8 || currentKey == 127 || currentKey == CARDKB_BS);
 }
 
 bool Keyboard::isTabHeld() {
@@ -297,41 +407,21 @@ bool Keyboard::isTabHeld() {
 }
 
 bool Keyboard::isUpPressed() {
-    bool pressed = (currentKey == CARDKB_UP);
-    if (pressed) {
-        currentKey = 0;  // Consume the key
-    }
-    return pressed;
+    return takeKey(currentKey == CARDKB_UP);
 }
 
 bool Keyboard::isDownPressed() {
-    bool pressed = (currentKey == CARDKB_DOWN);
-    if (pressed) {
-        currentKey = 0;  // Consume the key
-    }
-    return pressed;
+    return takeKey(currentKey == CARDKB_DOWN);
 }
 
 bool Keyboard::isLeftPressed() {
-    bool pressed = (currentKey == CARDKB_LEFT);
-    if (pressed) {
-        currentKey = 0;  // Consume the key
-    }
-    return pressed;
+    return takeKey(currentKey == CARDKB_LEFT);
 }
 
 bool Keyboard::isRightPressed() {
-    bool pressed = (currentKey == CARDKB_RIGHT);
-    if (pressed) {
-        currentKey = 0;  // Consume the key
-    }
-    return pressed;
+    return takeKey(currentKey == CARDKB_RIGHT);
 }
 
 bool Keyboard::isEscPressed() {
-    bool pressed = (currentKey == 0x1B);
-    if (pressed) {
-        currentKey = 0;  // Consume the key
-    }
-    return pressed;
+    return takeKey(currentKey == 0x1B);
 }
@@ -3,6 +3,10 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "KeyEventQueue.h"
+#ifdef KEYBOARD_USE_INTERRUPT
+#include <driver/gpio.h>
+#endif
 
 // CardKB special key codes
 #define CARDKB_UP    0xB5
@@ -16,8 +20,12 @@
 // Common I2C keyboard addresses
 #define KEYBOARD_I2C_ADDR 0x5F  // M5Stack CardKB I2C address
 
-// Keyboard buffer size
-#define KEY_BUFFER_SIZE 64
+// Interrupt-driven input (build with -D KEYBOARD_USE_INTERRUPT): a GPIO ISR on the
+// CardKB INT line wakes a reader task that drains keys into the event queue, so there is no
+// I2C traffic at rest and keys keep being captured while loop() is busy (e.g. during a
+// display refresh). update() then only processes the queue.
+#define KEYBOARD_DRAIN_MAX 16       // Reads per wake-up before yielding
+#define KEYBOARD_HOLD_POLL_MS 20    // Re-check interval while the INT line stays low
 
 class Keyboard {
 private:
@@ -27,22 +35,39 @@ private:
     
     String inputBuffer;
     char lastKey;
-    char currentKey;  // Current key being held
-    unsigned long lastKeyTime;
+    uint32_t lastKeyUs;  // Read time of lastKey, for debouncing
+    char currentKey;  // Special key waiting for a handler (or Tab being held)
+    uint32_t currentKeyUs;  // Read time of currentKey
+    uint32_t currentKeySeq;  // keyCount when currentKey was set
+    
+    // Every key read from the hardware, in order - a special key only leaves the
+    // queue once the previous one was consumed, so fast presses don't overwrite
+    KeyEventQueue events;
     
-    // Hardware buffer for capturing fast keypresses
-    char keyBuffer[KEY_BUFFER_SIZE];
-    volatile uint8_t bufferHead;
-    volatile uint8_t bufferTail;
+    // Producer-side repeat detection
+    char lastPushedKey;
+    uint32_t lastPushedUs;
     
     // Track for stuck key detection
     char lastRawKey;  // Track last raw I2C read to detect stuck keys
     uint8_t sameKeyCount;  // Count repeated identical reads
     
-    char readKey();
-    void bufferKey(char key);
-    char getBufferedKey();
-    bool hasBufferedKeys();
+    uint32_t keyCount;  // Keys accepted by update() - lets callers detect new input cheaply
+    
+    char readKey(uint8_t& modifiers);
+    void pushKey(char key, uint8_t modifiers);
+    bool takeKey(bool pressed);  // Consume currentKey if pressed
+    void consumed(uint32_t keyUs);
+    
+#ifdef KEYBOARD_USE_INTERRUPT
+    gpio_num_t intPin;
+    TaskHandle_t readerTask;
+    void (*keyCallback)();  // Called from the reader task after keys were queued
+    
+    static void IRAM_ATTR onInterrupt(void* arg);
+    static void readerTaskEntry(void* param);
+    void readerLoop();
+#endif
     
 public:
     Keyboard(TwoWire* w = &Wire, uint8_t addr = KEYBOARD_I2C_ADDR);
@@ -51,10 +76,20 @@ public:
     void update();  // Call this in loop()
     bool isKeyboardPresent();  // Check if hardware keyboard detected
     
+#ifdef KEYBOARD_USE_INTERRUPT
+    // After begin(): start the ISR and reader task. False = keep polling
+    bool beginInterrupt(uint8_t pin, void (*onKey)() = nullptr);
+    bool isInterruptDriven() { return readerTask != nullptr; }
+#else
+    bool isInterruptDriven() { return false; }
+#endif
+    // Queued keys the next update() can take (none while a special key awaits its handler)
+    bool hasPendingKeys() { return !events.isEmpty() && (currentKey == 0 || currentKey == CARDKB_TAB); }
+    
     // Input handling
     bool hasInput();
     String getInput();
-    void clearInput();
+    void clearInput();  // Text buffer, queued keys and any pending special key
     
     // Get current input buffer (for display)
     String getCurrentBuffer() { return inputBuffer; }
@@ -73,6 +108,17 @@ public:
     
     // Clear special key state (call after handling)
     void clearSpecialKey() { currentKey = 0; }
+    
+    // Drop a special key that was already pending before a handler pass (keyCount
+    // was keyCountBefore) and that the handler didn't consume - otherwise it would
+    // hold up the queue
+    void dropUnhandledKey(uint32_t keyCountBefore);
+    
+    // For loops that wait on one key without returning to the scheduler: drop whatever
+    // special key the wait just checked and didn't take, so the next key can arrive
+    void dropSpecialKey() { dropUnhandledKey(keyCount); }
+    
+    uint32_t getKeyCount() { return keyCount; }
 };
 
 #endif
@@ -1,15 +1,80 @@
 #include "Logger.h"
+#include "Metrics.h"
+#include "Scheduler.h"
+#include <Preferences.h>
 
-const char* Logger::LOG_FILE = "/debug.log";
+const char* Logger::SEGMENT_FILES[2] = { "/debug0.bin", "/debug1.bin" };
+// Old text log and single-file ring, removed on first boot
+const char* Logger::LEGACY_LOG_FILES[2] = { "/debug.log", "/debug.bin" };
 
 // Global logger instance
 Logger logger;
 
+LogQueue::LogQueue() {
+    for (uint32_t i = 0; i < LOG_QUEUE_CAPACITY; i++) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos.store(0, std::memory_order_relaxed);
+    dequeuePos = 0;
+}
+
+bool LogQueue::push(const LogQueueEntry& entry) {
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    
+    for (;;) {
+        cell = &cells[pos & (LOG_QUEUE_CAPACITY - 1)];
+        uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)seq - (int32_t)pos;
+        
+        if (diff == 0) {
+            // Cell is free for this position - claim it
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;  // Full - consumer hasn't freed this cell yet
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);  // Another producer won, retry
+        }
+    }
+    
+    // Only copy the used part of the text
+    size_t bytes = offsetof(LogQueueEntry, text) + entry.length;
+    memcpy(&cell->entry, &entry, bytes);
+    cell->sequence.store(pos + 1, std::memory_order_release);  // Publish to consumer
+    return true;
+}
+
+bool LogQueue::pop(LogQueueEntry& entry) {
+    Cell* cell = &cells[dequeuePos & (LOG_QUEUE_CAPACITY - 1)];
+    uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+    if ((int32_t)seq - (int32_t)(dequeuePos + 1) < 0) {
+        return false;  // Empty
+    }
+    
+    memcpy(&entry, &cell->entry, offsetof(LogQueueEntry, text) + cell->entry.length);
+    cell->sequence.store(dequeuePos + LOG_QUEUE_CAPACITY, std::memory_order_release);  // Free for reuse
+    dequeuePos++;
+    return true;
+}
+
+bool LogQueue::isEmpty() const {
+    const Cell& cell = cells[dequeuePos & (LOG_QUEUE_CAPACITY - 1)];
+    return (int32_t)cell.sequence.load(std::memory_order_acquire) - (int32_t)(dequeuePos + 1) < 0;
+}
+
 Logger::Logger() {
     currentLevel = LOG_INFO;
     bootTime = 0;
     serialConnected = false;
     deviceMAC = ESP.getEfuseMac();
+    activeSegment = 0;
+    segmentRecords = 0;
+    nextSeq = 1;
+    unflushed = 0;
+    fileLock = nullptr;
+    sinkTask = nullptr;
+    droppedCount.store(0);
+    reportedDrops = 0;
     
     // Generate debug topic from MAC
     char macStr[13];
@@ -25,8 +90,31 @@ bool Logger::begin() {
         return false;
     }
     
-    // Load existing log from file
-    loadBufferFromFile();
+    // Superseded log formats
+    for (const char* legacy : LEGACY_LOG_FILES) {
+        if (LittleFS.exists(legacy)) {
+            LittleFS.remove(legacy);
+        }
+    }
+    
+    // Level set with !LOGLEVEL - debug output (LOG_D, LOG_TRACE) stays off until then
+    Preferences prefs;
+    if (prefs.begin(LOG_PREFS_NAMESPACE, true)) {
+        uint8_t level = prefs.getUChar("level", LOG_INFO);
+        if (level <= LOG_CRITICAL) currentLevel = (LogLevel)level;
+        prefs.end();
+    }
+    
+    fileLock = xSemaphoreCreateMutex();
+    if (!openLogFile()) {
+        Serial.println(F("[Logger] ERROR: Failed to open log file - serial only"));
+    }
+    
+    // Low-priority sink: Serial and flash I/O happen here, never on the caller's task
+    // (the MQTT event handler logs on the ESP-MQTT task)
+    if (!sinkTask) {
+        xTaskCreate(sinkTaskEntry, "logsink", 4096, this, 1, &sinkTask);
+    }
     
     // Log boot event
     logBoot();
@@ -37,6 +125,11 @@ bool Logger::begin() {
 
 void Logger::setLogLevel(LogLevel level) {
     currentLevel = level;
+    
+    Preferences prefs;
+    prefs.begin(LOG_PREFS_NAMESPACE, false);
+    prefs.putUChar("level", (uint8_t)level);
+    prefs.end();
 }
 
 void Logger::log(LogLevel level, const String& message) {
@@ -45,34 +138,121 @@ void Logger::log(LogLevel level, const String& message) {
         return;
     }
     
-    // Create log entry
-    LogEntry entry;
+    emit(level, 0, message.c_str(), message.length());
+}
+
+void Logger::logf(LogLevel level, const char* format, ...) {
+    if (level < currentLevel) {
+        return;
+    }
+    
+    // Format on the stack - no heap String for the message
+    char buffer[LOG_QUEUE_TEXT_LEN];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    
+    if (length < 0) return;
+    emit(level, 0, buffer, min((size_t)length, sizeof(buffer) - 1));
+}
+
+void Logger::tracef(const char* format, ...) {
+    char buffer[LOG_QUEUE_TEXT_LEN];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    
+    if (length < 0) return;
+    emit(LOG_DEBUG, LOG_FLAG_SERIAL_ONLY, buffer, min((size_t)length, sizeof(buffer) - 1));
+}
+
+void Logger::emit(LogLevel level, uint8_t flags, const char* text, size_t length) {
+    LogQueueEntry entry;
     entry.timestamp = millis();
-    entry.level = level;
-    entry.message = message;
-    
-    // Add to buffer
-    logBuffer.push_back(entry);
-    
-    // Also output to Serial immediately for real-time monitoring
-    Serial.print("[");
-    Serial.print(entry.timestamp);
-    Serial.print("] ");
-    Serial.print(levelToString(level));
-    Serial.print(": ");
-    Serial.println(message);
-    
-    // Prune if buffer is too large
-    if (logBuffer.size() > MAX_ENTRIES) {
-        pruneOldEntries();
+    entry.level = (uint8_t)level;
+    entry.flags = flags;
+    entry.length = min(length, (size_t)LOG_QUEUE_TEXT_LEN);
+    memcpy(entry.text, text, entry.length);
+    
+    if (!sinkTask) {
+        writeOut(entry);  // Before begin() - no sink yet, write directly
+        return;
+    }
+    
+    if (queue.push(entry)) {
+        xTaskNotifyGive(sinkTask);
+    } else {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::sinkTaskEntry(void* param) {
+    Logger* self = (Logger*)param;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        self->drainQueue();
+    }
+}
+
+void Logger::drainQueue() {
+    LogQueueEntry entry;
+    while (queue.pop(entry)) {
+        writeOut(entry);
     }
     
-    // Periodically write to file (every 10 entries to reduce flash wear)
-    if (logBuffer.size() % 10 == 0) {
-        writeBufferToFile();
+    // Report overflow once the backlog has cleared
+    uint32_t dropped = droppedCount.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops) {
+        char text[48];
+        int length = snprintf(text, sizeof(text), "Log queue overflow: %u records dropped", (unsigned)(dropped - reportedDrops));
+        reportedDrops = dropped;
+        
+        LogQueueEntry notice;
+        notice.timestamp = millis();
+        notice.level = LOG_ERROR;
+        notice.flags = 0;
+        notice.length = length;
+        memcpy(notice.text, text, length);
+        writeOut(notice);
     }
 }
 
+void Logger::writeOut(const LogQueueEntry& entry) {
+    if (entry.flags & LOG_FLAG_SERIAL_ONLY) {
+        Serial.write((const uint8_t*)entry.text, entry.length);
+        Serial.println();
+        return;
+    }
+    
+    // Also output to Serial for real-time monitoring
+    Serial.printf("[%lu] %s: ", (unsigned long)entry.timestamp, levelName((LogLevel)entry.level));
+    Serial.write((const uint8_t*)entry.text, entry.length);
+    Serial.println();
+    
+    if (fileLock) xSemaphoreTake(fileLock, portMAX_DELAY);
+    writeRecord(entry.timestamp, (LogLevel)entry.level, entry.text, entry.length);
+    if (fileLock) xSemaphoreGive(fileLock);
+}
+
+void Logger::flush(unsigned long timeoutMs) {
+    if (sinkTask) {
+        xTaskNotifyGive(sinkTask);
+        unsigned long start = millis();
+        while (!queue.isEmpty() && millis() - start < timeoutMs) {
+            delay(5);
+        }
+    }
+    
+    if (fileLock) xSemaphoreTake(fileLock, portMAX_DELAY);
+    if (logFile) {
+        logFile.flush();
+        unflushed = 0;
+    }
+    if (fileLock) xSemaphoreGive(fileLock);
+}
+
 void Logger::debug(const String& message) {
     log(LOG_DEBUG, message);
 }
@@ -98,89 +278,120 @@ void Logger::logSessionMarker(const String& marker) {
     info("===== " + marker + " =====");
 }
 
-void Logger::pruneOldEntries() {
-    if (logBuffer.size() <= PRUNE_COUNT) {
-        return;
+// Find where to continue after a reboot or crash: the active segment is the one
+// whose last record is newest. Only the last record of each file is read.
+bool Logger::openLogFile() {
+    uint32_t records[2];
+    bool torn[2];
+    uint32_t lastSeq[2];
+    for (int i = 0; i < 2; i++) {
+        lastSeq[i] = lastSeqIn(i, records[i], torn[i]);
     }
     
-    // Remove oldest 25% of entries
-    logBuffer.erase(logBuffer.begin(), logBuffer.begin() + PRUNE_COUNT);
+    activeSegment = lastSeq[1] > lastSeq[0] ? 1 : 0;
+    nextSeq = max(lastSeq[0], lastSeq[1]) + 1;
+    unflushed = 0;
     
-    info("Log buffer pruned, removed " + String(PRUNE_COUNT) + " old entries");
+    // A torn tail would misalign every later append - start the other segment instead
+    if (torn[activeSegment] || records[activeSegment] >= LOG_SEGMENT_RECORDS) {
+        return startSegment(activeSegment ^ 1);
+    }
+    
+    logFile = LittleFS.open(SEGMENT_FILES[activeSegment], "a");
+    segmentRecords = records[activeSegment];
+    Serial.print(F("[Logger] Log recovered, next record "));
+    Serial.println(nextSeq);
+    return (bool)logFile;
 }
 
-void Logger::writeBufferToFile() {
-    File file = LittleFS.open(LOG_FILE, "w");
-    if (!file) {
-        Serial.println(F("[Logger] ERROR: Failed to open log file for writing"));
-        return;
-    }
+// Truncate a segment and make it the active one
+bool Logger::startSegment(int segment) {
+    if (logFile) logFile.close();
+    activeSegment = segment;
+    segmentRecords = 0;
+    logFile = LittleFS.open(SEGMENT_FILES[segment], "w");
+    return (bool)logFile;
+}
+
+// Sequence number of the last complete, intact record in a segment (0 = none)
+uint32_t Logger::lastSeqIn(int segment, uint32_t& records, bool& torn) {
+    records = 0;
+    torn = false;
     
-    // Write each log entry
-    for (const auto& entry : logBuffer) {
-        file.print("[");
-        file.print(entry.timestamp);
-        file.print("] ");
-        file.print(levelToString(entry.level));
-        file.print(": ");
-        file.println(entry.message);
-    }
+    File file = LittleFS.open(SEGMENT_FILES[segment], "r");
+    if (!file) return 0;
     
+    size_t size = file.size();
+    records = size / sizeof(LogRecord);
+    torn = (size % sizeof(LogRecord)) != 0;
+    
+    uint32_t seq = 0;
+    LogRecord record;
+    if (records > 0) {
+        file.seek((records - 1) * sizeof(LogRecord));
+        if (readRecord(file, record)) {
+            seq = record.seq;
+        } else {
+            torn = true;  // Interrupted before the flush completed
+        }
+    }
     file.close();
+    return seq;
 }
 
-void Logger::loadBufferFromFile() {
-    if (!LittleFS.exists(LOG_FILE)) {
-        Serial.println(F("[Logger] No existing log file found"));
-        return;
-    }
-    
-    File file = LittleFS.open(LOG_FILE, "r");
-    if (!file) {
-        Serial.println(F("[Logger] ERROR: Failed to open log file for reading"));
-        return;
+uint16_t Logger::checksum(const LogRecord& record) {
+    // FNV-1a over everything except the check field, folded to 16 bits
+    uint32_t hash = 2166136261u;
+    const uint8_t* bytes = (const uint8_t*)&record;
+    size_t checkOffset = offsetof(LogRecord, check);
+    size_t end = offsetof(LogRecord, text) + record.length;
+    for (size_t i = 0; i < end; i++) {
+        if (i == checkOffset) {
+            i += sizeof(record.check) - 1;
+            continue;
+        }
+        hash = (hash ^ bytes[i]) * 16777619u;
     }
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+void Logger::writeRecord(uint32_t timestamp, LogLevel level, const char* text, size_t length) {
+    if (!logFile) return;
     
-    logBuffer.clear();
+    LogRecord record;
+    memset(&record, 0, sizeof(record));
+    record.seq = nextSeq;
+    record.timestamp = timestamp;
+    record.level = (uint8_t)level;
+    record.length = min(length, (size_t)LOG_TEXT_LEN);
+    memcpy(record.text, text, record.length);
+    record.check = checksum(record);
     
-    // Parse log entries from file
-    while (file.available()) {
-        String line = file.readStringUntil('\n');
-        line.trim();
-        
-        if (line.length() == 0) continue;
-        
-        // Parse: [timestamp] LEVEL: message
-        int timestampEnd = line.indexOf(']');
-        int levelEnd = line.indexOf(':', timestampEnd);
-        
-        if (timestampEnd > 0 && levelEnd > timestampEnd) {
-            LogEntry entry;
-            entry.timestamp = line.substring(1, timestampEnd).toInt();
-            
-            String levelStr = line.substring(timestampEnd + 2, levelEnd);
-            levelStr.trim();
-            if (levelStr == "DEBUG") entry.level = LOG_DEBUG;
-            else if (levelStr == "INFO") entry.level = LOG_INFO;
-            else if (levelStr == "ERROR") entry.level = LOG_ERROR;
-            else if (levelStr == "CRITICAL") entry.level = LOG_CRITICAL;
-            else entry.level = LOG_INFO;
-            
-            entry.message = line.substring(levelEnd + 1);
-            entry.message.trim();
-            
-            logBuffer.push_back(entry);
-        }
+    // Active segment full - the older one is discarded and takes over
+    if (segmentRecords >= LOG_SEGMENT_RECORDS) {
+        logFile.flush();
+        if (!startSegment(activeSegment ^ 1)) return;
     }
     
-    file.close();
+    logFile.write((const uint8_t*)&record, sizeof(record));
+    segmentRecords++;
+    nextSeq++;
     
-    Serial.print(F("[Logger] Loaded "));
-    Serial.print(logBuffer.size());
-    Serial.println(F(" log entries from file"));
+    // Batch flushes to limit flash wear, but never sit on an error
+    unflushed++;
+    if (unflushed >= FLUSH_EVERY || level >= LOG_ERROR) {
+        logFile.flush();
+        unflushed = 0;
+    }
 }
 
-String Logger::levelToString(LogLevel level) {
+bool Logger::readRecord(File& file, LogRecord& record) {
+    if (file.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) return false;
+    if (record.seq == 0 || record.length > LOG_TEXT_LEN) return false;
+    return record.check == checksum(record);
+}
+
+const char* Logger::levelName(LogLevel level) {
     switch (level) {
         case LOG_DEBUG: return "DEBUG";
         case LOG_INFO: return "INFO";
@@ -190,30 +401,58 @@ String Logger::levelToString(LogLevel level) {
     }
 }
 
-void Logger::dumpToSerial() {
-    Serial.println(F("\n========== DEBUG LOG DUMP =========="));
-    Serial.print(F("Total entries: "));
-    Serial.println(logBuffer.size());
-    Serial.println(F("====================================\n"));
+// Print one segment's intact records in order; returns how many were printed
+uint32_t Logger::dumpSegment(int segment) {
+    File file = LittleFS.open(SEGMENT_FILES[segment], "r");
+    if (!file) return 0;
     
-    for (const auto& entry : logBuffer) {
+    uint32_t printed = 0;
+    LogRecord record;
+    size_t records = file.size() / sizeof(LogRecord);
+    for (size_t i = 0; i < records; i++) {
+        file.seek(i * sizeof(LogRecord));
+        if (!readRecord(file, record)) continue;  // Torn record from a crash
+        
         Serial.print("[");
-        Serial.print(entry.timestamp);
+        Serial.print(record.timestamp);
         Serial.print("] ");
-        Serial.print(levelToString(entry.level));
+        Serial.print(levelName((LogLevel)record.level));
         Serial.print(": ");
-        Serial.println(entry.message);
+        Serial.write((const uint8_t*)record.text, record.length);
+        Serial.println();
+        printed++;
     }
+    file.close();
+    return printed;
+}
+
+void Logger::dumpToSerial() {
+    flush();  // Queued records first, so the dump is complete
+    
+    Serial.println(F("\n========== DEBUG LOG DUMP =========="));
     
+    if (fileLock) xSemaphoreTake(fileLock, portMAX_DELAY);
+    // Older segment first - it holds the records before the active one's
+    uint32_t total = dumpSegment(activeSegment ^ 1);
+    total += dumpSegment(activeSegment);
+    if (fileLock) xSemaphoreGive(fileLock);
+    
+    Serial.print(F("Total entries: "));
+    Serial.println(total);
     Serial.println(F("\n========== END LOG DUMP ==========\n"));
 }
 
 void Logger::clearLog() {
-    logBuffer.clear();
-    
-    if (LittleFS.exists(LOG_FILE)) {
-        LittleFS.remove(LOG_FILE);
+    flush();
+    if (fileLock) xSemaphoreTake(fileLock, portMAX_DELAY);
+    if (logFile) {
+        logFile.close();
     }
+    LittleFS.remove(SEGMENT_FILES[1]);
+    startSegment(0);
+    nextSeq = 1;
+    unflushed = 0;
+    if (fileLock) xSemaphoreGive(fileLock);
     
     info("Log cleared");
     Serial.println(F("[Logger] Log cleared"));
@@ -246,6 +485,33 @@ void Logger::update() {
             dumpToSerial();
         } else if (cmd == "!CLEARLOG") {
             clearLog();
+        } else if (cmd == "!METRICS") {
+            metrics.printSnapshot(Serial);
+        } else if (cmd == "!RESETMETRICS") {
+            metrics.reset();
+            Serial.println("Metrics reset");
+        } else if (cmd == "!TASKS") {
+            scheduler.printStats(Serial);
+        } else if (cmd == "!RESETTASKS") {
+            scheduler.resetStats();
+            Serial.println("Task stats reset");
+        } else if (cmd.startsWith("!LOGLEVEL")) {
+            // !LOGLEVEL [DEBUG|INFO|ERROR|CRITICAL] - no argument prints the current level
+            String name = cmd.substring(9);
+            name.trim();
+            name.toUpperCase();
+            for (int level = LOG_DEBUG; level <= LOG_CRITICAL; level++) {
+                if (name == levelName((LogLevel)level)) {
+                    setLogLevel((LogLevel)level);
+                    break;
+                }
+            }
+            Serial.println("Log level: " + String(levelName(currentLevel)));
+#ifdef LOG_STRIP_DEBUG
+            if (currentLevel == LOG_DEBUG) {
+                Serial.println("Built with LOG_STRIP_DEBUG - LOG_D/LOG_TRACE are compiled out");
+            }
+#endif
         } else if (cmd == "!BEEP") {
             // Test buzzer command
             Serial.println("Testing buzzer on GPIO 16...");
@@ -3,7 +3,7 @@
 
 #include <Arduino.h>
 #include <LittleFS.h>
-#include <vector>
+#include <atomic>
 
 // Log levels
 enum LogLevel {
@@ -13,12 +13,64 @@ enum LogLevel {
     LOG_CRITICAL = 3
 };
 
+// One fixed-size record in the on-flash log. Records are only ever appended, to two
+// rotating segment files: when the active one holds LOG_SEGMENT_RECORDS, the other
+// (older) one is truncated and becomes active. LittleFS is copy-on-write, so an
+// append only reprograms the file's last block - an in-place write would rewrite
+// everything from the write point to EOF.
+#define LOG_SEGMENT_RECORDS 256  // 256 x 96 bytes = 24KB per segment, 48KB total
+#define LOG_TEXT_LEN 84          // Message bytes per record (longer messages are truncated)
+#define LOG_PREFS_NAMESPACE "logger"  // Persisted log level (!LOGLEVEL)
+
+struct LogRecord {
+    uint32_t seq;              // Monotonic sequence number
+    uint32_t timestamp;        // millis() at log time
+    uint8_t level;             // LogLevel
+    uint8_t length;            // Bytes used in text
+    uint16_t check;            // Checksum over the rest of the record - detects torn writes
+    char text[LOG_TEXT_LEN];
+};
+
+// Bounded lock-free MPSC queue between log producers (loop, MQTT task, ...) and the
+// sink task that does the slow Serial/flash I/O. Vyukov-style: each cell carries a
+// sequence number, producers claim cells with one CAS, the single consumer needs none.
+// Full queue = the record is dropped and counted, never blocks the producer.
+#define LOG_QUEUE_CAPACITY 32      // Power of two
+#define LOG_QUEUE_TEXT_LEN 160     // Serial gets the full line; the flash ring keeps LOG_TEXT_LEN
+
+#define LOG_FLAG_SERIAL_ONLY 0x01  // Trace output - not stored in the flash ring
+
+struct LogQueueEntry {
+    uint32_t timestamp;
+    uint8_t level;
+    uint8_t flags;
+    uint16_t length;
+    char text[LOG_QUEUE_TEXT_LEN];
+};
+
+class LogQueue {
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        LogQueueEntry entry;
+    };
+    
+    Cell cells[LOG_QUEUE_CAPACITY];
+    std::atomic<uint32_t> enqueuePos;
+    uint32_t dequeuePos;  // Consumer only
+    
+public:
+    LogQueue();
+    bool push(const LogQueueEntry& entry);  // Any task; false if full
+    bool pop(LogQueueEntry& entry);         // Sink task only; false if empty
+    bool isEmpty() const;
+};
+
 class Logger {
 private:
-    static const char* LOG_FILE;
-    static const size_t MAX_LOG_SIZE = 50000;  // 50KB max
-    static const size_t MAX_ENTRIES = 500;     // ~500 log entries
-    static const size_t PRUNE_COUNT = 125;     // Delete 25% when full
+    static const char* SEGMENT_FILES[2];
+    static const char* LEGACY_LOG_FILES[2];
+    static const size_t FLUSH_EVERY = 10;      // Records between flushes (errors flush immediately)
     
     LogLevel currentLevel;
     unsigned long bootTime;
@@ -26,28 +78,45 @@ private:
     uint64_t deviceMAC;
     String debugTopic;
     
-    struct LogEntry {
-        unsigned long timestamp;
-        LogLevel level;
-        String message;
-    };
+    File logFile;              // Active segment, kept open for appending
+    int activeSegment;         // Index into SEGMENT_FILES
+    uint32_t segmentRecords;   // Records in the active segment
+    uint32_t nextSeq;          // Sequence number for the next record
+    size_t unflushed;          // Records written since last flush
+    SemaphoreHandle_t fileLock;  // Sink task vs. dump/clear on the loop task
+    
+    // Async sink - producers only format and enqueue
+    LogQueue queue;
+    TaskHandle_t sinkTask;
+    std::atomic<uint32_t> droppedCount;  // Records lost to a full queue
+    uint32_t reportedDrops;
     
-    std::vector<LogEntry> logBuffer;
+    static void sinkTaskEntry(void* param);
+    void drainQueue();
+    void writeOut(const LogQueueEntry& entry);
     
-    void pruneOldEntries();
-    void writeBufferToFile();
-    void loadBufferFromFile();
-    String levelToString(LogLevel level);
+    bool openLogFile();
+    bool startSegment(int segment);
+    uint32_t lastSeqIn(int segment, uint32_t& records, bool& torn);
+    void writeRecord(uint32_t timestamp, LogLevel level, const char* text, size_t length);
+    void emit(LogLevel level, uint8_t flags, const char* text, size_t length);
+    bool readRecord(File& file, LogRecord& record);
+    uint32_t dumpSegment(int segment);
+    static uint16_t checksum(const LogRecord& record);
+    static const char* levelName(LogLevel level);
     void checkSerialConnection();
     
 public:
     Logger();
     
     bool begin();
-    void setLogLevel(LogLevel level);
+    void setLogLevel(LogLevel level);  // Persisted - a debug level survives the next reset
     
     // Main logging functions
+    bool isEnabled(LogLevel level) const { return level >= currentLevel; }
     void log(LogLevel level, const String& message);
+    void logf(LogLevel level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+    void tracef(const char* format, ...) __attribute__((format(printf, 2, 3)));  // Serial only
     void debug(const String& message);
     void info(const String& message);
     void error(const String& message);
@@ -57,6 +126,10 @@ public:
     void logBoot();
     void logSessionMarker(const String& marker);
     
+    // Wait (bounded) for queued records to reach Serial and flash - before sleep/restart
+    void flush(unsigned long timeoutMs = 500);
+    uint32_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+    
     // Dump log to serial
     void dumpToSerial();
     void clearLog();
@@ -68,4 +141,29 @@ public:
 // Global logger instance
 extern Logger logger;
 
+// Logging macros - prefer these over logger.info("..." + String(x)) on hot paths.
+// Formatting is deferred (printf-style, into a stack buffer) and the arguments are
+// not evaluated at all when the level is filtered out.
+//
+// Build with -D LOG_STRIP_DEBUG to compile out LOG_D and LOG_TRACE call sites
+// entirely (see platformio.ini).
+#define LOG_AT(level, format, ...) \
+    do { if (logger.isEnabled(level)) logger.logf(level, format, ##__VA_ARGS__); } while (0)
+
+#define LOG_I(format, ...) LOG_AT(LOG_INFO, format, ##__VA_ARGS__)
+#define LOG_E(format, ...) LOG_AT(LOG_ERROR, format, ##__VA_ARGS__)
+#define LOG_C(format, ...) LOG_AT(LOG_CRITICAL, format, ##__VA_ARGS__)
+
+#ifdef LOG_STRIP_DEBUG
+#define LOG_D(format, ...) do { } while (0)
+#define LOG_TRACE(tag, format, ...) do { } while (0)
+#else
+#define LOG_D(format, ...) LOG_AT(LOG_DEBUG, format, ##__VA_ARGS__)
+// Serial-only trace (not stored in the log ring) - replaces Serial.println("[Tag] " + ...).
+// Debug level like LOG_D: nothing is formatted or queued unless debug logging is on
+// (!LOGLEVEL DEBUG over serial - persisted, so it also covers the next boot)
+#define LOG_TRACE(tag, format, ...) \
+    do { if (logger.isEnabled(LOG_DEBUG)) logger.tracef("[" tag "] " format, ##__VA_ARGS__); } while (0)
+#endif
+
 #endif
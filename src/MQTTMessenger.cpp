@@ -1,5 +1,6 @@
 #include "MQTTMessenger.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include <mbedtls/base64.h>
 
 // Let's Encrypt R12 intermediate certificate for HiveMQ Cloud TLS
@@ -57,11 +58,14 @@ MQTTMessenger::MQTTMessenger() {
     currentSyncPhase = 0;  // Not syncing
     syncTargetMAC = "";
     lastSyncPhaseTime = 0;
+    syncPhaseStartUs = 0;
     
-    // Generate unique client ID from MAC with timestamp to avoid conflicts
+    sessionPresent = false;
+    
+    // Stable client ID from MAC so the broker can resume our session across reboots and naps
     char macStr[13];
     sprintf(macStr, "%012llx", myMAC);
-    clientId = "smol_esp_" + String(macStr) + "_" + String(millis());
+    clientId = "smol_esp_" + String(macStr);
 }
 
 bool MQTTMessenger::begin() {
@@ -70,6 +74,12 @@ bool MQTTMessenger::begin() {
         return false;
     }
     
+    if (mqttClient) {
+        // Already started (e.g. by the nap fast-wake path) - ESP-MQTT auto-reconnects
+        Serial.println("[MQTT] Client already running");
+        return true;
+    }
+    
     Serial.println("[MQTT] Initializing ESP-MQTT messenger");
     Serial.println("[MQTT] Broker: " + String(MQTT_BROKER_URI));
     Serial.println("[MQTT] Username: " + String(MQTT_USERNAME));
@@ -104,13 +114,15 @@ bool MQTTMessenger::begin() {
         logger.info("MQTT: Plain MQTT (no TLS)");
     }
     
-    mqtt_cfg.disable_clean_session = 1;  // 1 = disable persistent session (try clean session first)
+    // clean_session=false: the broker keeps our subscriptions and queues QoS 1 village
+    // traffic while we're asleep, then flushes it when we reconnect with the same client ID
+    mqtt_cfg.disable_clean_session = true;
     mqtt_cfg.keepalive = 60;  // Shorter keepalive
     mqtt_cfg.disable_auto_reconnect = false;  // Enable auto-reconnect
     mqtt_cfg.network_timeout_ms = 10000;  // 10 second timeout
     mqtt_cfg.protocol_ver = MQTT_PROTOCOL_V_3_1_1;  // Explicitly use MQTT 3.1.1
     
-    logger.info("MQTT: Config set - clean_session=true keepalive=60");
+    logger.info("MQTT: Config set - clean_session=false keepalive=60");
     
     //  Based on community research: ESP-MQTT TLS has ~20% initial connection failure rate
     // Solution: Retry mechanism (1-2 retries resolves 97% of issues)
@@ -266,6 +278,7 @@ void MQTTMessenger::cleanupSeenMessages() {
     if (seenMessageIds.size() > 100) {
         Serial.println("[MQTT] Clearing old seen message IDs (" + String(seenMessageIds.size()) + " entries)");
         seenMessageIds.clear();
+        metrics.setGauge(GAUGE_SEEN_IDS, 0);
     }
     
 
@@ -285,6 +298,7 @@ void MQTTMessenger::mqttEventHandler(void *handler_args, esp_event_base_t base,
             Serial.println("[MQTT] Connected to broker!");
             Serial.println("[MQTT] Session present: " + String(event->session_present ? "yes" : "no"));
             self->connected = true;
+            self->sessionPresent = event->session_present;
             
             // Subscribe to all saved villages with QoS 1
             if (self->subscribedVillages.size() > 0) {
@@ -360,7 +374,7 @@ void MQTTMessenger::mqttEventHandler(void *handler_args, esp_event_base_t base,
 // void MQTTMessenger::onMqttMessage(char* topic, char* payload, ...) { ... }
 
 void MQTTMessenger::handleIncomingMessage(const String& topic, const uint8_t* payload, unsigned int length) {
-    Serial.println("[MQTT] Received on topic: " + topic);
+    LOG_TRACE("MQTT", "Received on topic: %s", topic.c_str());
     
     // Check if this is a command message
     char macStr[13];
@@ -373,8 +387,8 @@ void MQTTMessenger::handleIncomingMessage(const String& topic, const uint8_t* pa
         for (unsigned int i = 0; i < length; i++) {
             command += (char)payload[i];
         }
-        Serial.println("[MQTT] Received command: " + command);
-        logger.info("MQTT command: " + command);
+        LOG_TRACE("MQTT", "Received command: %s", command.c_str());
+        LOG_I("MQTT command: %s", command.c_str());
         
         if (onCommandReceived) {
             onCommandReceived(command);
@@ -393,36 +407,36 @@ void MQTTMessenger::handleIncomingMessage(const String& topic, const uint8_t* pa
     int firstSlash = topic.indexOf('/');
     int secondSlash = topic.indexOf('/', firstSlash + 1);
     if (firstSlash == -1 || secondSlash == -1) {
-        Serial.println("[MQTT] Invalid topic format");
+        LOG_TRACE("MQTT", "Invalid topic format");
         return;
     }
     
     String villageId = topic.substring(firstSlash + 1, secondSlash);
-    Serial.println("[MQTT] Message for village: " + villageId);
+    LOG_TRACE("MQTT", "Message for village: %s", villageId.c_str());
     
     // Check for invite code topics (smoltxt/invites/{code})
     if (topic.startsWith("smoltxt/invites/")) {
         String inviteCode = topic.substring(16);  // Skip "smoltxt/invites/"
-        Serial.println("[MQTT] ====== INVITE DATA RECEIVED ======");
-        Serial.println("[MQTT] Received invite data for code: " + inviteCode);
-        Serial.println("[MQTT] Payload length: " + String(length));
+        LOG_TRACE("MQTT", "====== INVITE DATA RECEIVED ======");
+        LOG_TRACE("MQTT", "Received invite data for code: %s", inviteCode.c_str());
+        LOG_TRACE("MQTT", "Payload length: %u", length);
         
         // Parse JSON payload
         String message = "";
         for (unsigned int i = 0; i < length; i++) {
             message += (char)payload[i];
         }
-        Serial.println("[MQTT] Invite payload: " + message);
+        LOG_TRACE("MQTT", "Invite payload: %s", message.c_str());
         
         if (message.length() == 0) {
-            Serial.println("[MQTT] Empty invite payload (unpublished/cleared)");
+            LOG_TRACE("MQTT", "Empty invite payload (unpublished/cleared)");
             return;
         }
         
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, message);
         if (error) {
-            Serial.println("[MQTT] Invite JSON parse error: " + String(error.c_str()));
+            LOG_TRACE("MQTT", "Invite JSON parse error: %s", error.c_str());
             return;
         }
         
@@ -430,8 +444,8 @@ void MQTTMessenger::handleIncomingMessage(const String& topic, const uint8_t* pa
         String inviteVillageName = doc["villageName"] | "";
         String encodedKey = doc["key"] | "";
         
-        Serial.println("[MQTT] Parsed - Name: " + inviteVillageName + ", ID: " + inviteVillageId);
-        Serial.println("[MQTT] Encoded key length: " + String(encodedKey.length()));
+        LOG_TRACE("MQTT", "Parsed - Name: %s, ID: %s", inviteVillageName.c_str(), inviteVillageId.c_str());
+        LOG_TRACE("MQTT", "Encoded key length: %u", encodedKey.length());
         
         // Decode the encryption key from base64
         uint8_t decodedKey[32];
@@ -440,19 +454,19 @@ void MQTTMessenger::handleIncomingMessage(const String& topic, const uint8_t* pa
                             (const unsigned char*)encodedKey.c_str(), encodedKey.length());
         
         if (decodedLen == 32) {
-            Serial.println("[MQTT] Invite received: " + inviteVillageName + " (" + inviteVillageId + ")");
-            logger.info("Invite received: " + inviteVillageName);
+            LOG_TRACE("MQTT", "Invite received: %s (%s)", inviteVillageName.c_str(), inviteVillageId.c_str());
+            LOG_I("Invite received: %s", inviteVillageName.c_str());
             
             if (onInviteReceived) {
-                Serial.println("[MQTT] Calling onInviteReceived callback");
+                LOG_TRACE("MQTT", "Calling onInviteReceived callback");
                 onInviteReceived(inviteVillageId, inviteVillageName, decodedKey, 32);
             } else {
-                Serial.println("[MQTT] WARNING: No onInviteReceived callback set!");
+                LOG_TRACE("MQTT", "WARNING: No onInviteReceived callback set!");
             }
         } else {
-            Serial.println("[MQTT] Invite key decode failed: wrong length " + String(decodedLen));
+            LOG_TRACE("MQTT", "Invite key decode failed: wrong length %u", (unsigned)decodedLen);
         }
-        Serial.println("[MQTT] ===================================");
+        LOG_TRACE("MQTT", "===================================");
         return;
     }
     
@@ -462,8 +476,8 @@ void MQTTMessenger::handleIncomingMessage(const String& topic, const uint8_t* pa
         for (unsigned int i = 0; i < length; i++) {
             villageName += (char)payload[i];
         }
-        Serial.println("[MQTT] Received village name announcement: " + villageName + " for village: " + villageId);
-        logger.info("Village name received: " + villageName + " (ID: " + villageId + ")");
+        LOG_TRACE("MQTT", "Received village name announcement: %s for village: %s", villageName.c_str(), villageId.c_str());
+        LOG_I("Village name received: %s (ID: %s)", villageName.c_str(), villageId.c_str());
         
         if (onVillageNameReceived) {
             onVillageNameReceived(villageId, villageName);
@@ -480,7 +494,7 @@ void MQTTMessenger::handleIncomingMessage(const String& topic, const uint8_t* pa
     // Find the village subscription to get the encryption key
     VillageSubscription* village = findVillageSubscription(villageId);
     if (!village) {
-        Serial.println("[MQTT] Village not found in subscriptions: " + villageId);
+        LOG_TRACE("MQTT", "Village not found in subscriptions: %s", villageId.c_str());
         return;
     }
     
@@ -492,27 +506,35 @@ void MQTTMessenger::handleIncomingMessage(const String& topic, const uint8_t* pa
     String message;
     
     if (!tempEncryption.decryptString(payload, length, message)) {
-        Serial.println("[MQTT] Decryption failed for village: " + village->villageName);
-        logger.error("MQTT: Decryption failed for " + village->villageName);
+        metrics.increment(CTR_DECRYPT_FAILED);
+        LOG_TRACE("MQTT", "Decryption failed for village: %s", village->villageName.c_str());
+        LOG_E("MQTT: Decryption failed for %s", village->villageName.c_str());
         return;
     }
     
-    Serial.println("[MQTT] Decrypted message from " + village->villageName + ": " + message);
+    LOG_TRACE("MQTT", "Decrypted message from %s: %s", village->villageName.c_str(), message.c_str());
     
     // Parse message format: TYPE:villageId:target:sender:senderMAC:msgId:content:hop:maxHop
-    ParsedMessage msg = parseMessage(message);
+    ParsedMessage msg;
+    {
+        MetricTimer timer(HIST_PARSE);
+        msg = parseMessage(message);
+    }
     
     if (msg.type == MSG_UNKNOWN) {
-        Serial.println("[MQTT] Failed to parse message");
+        LOG_TRACE("MQTT", "Failed to parse message");
         return;
     }
     
     // Check if we've seen this message before
+    metrics.increment(CTR_MQTT_RECEIVED);
     if (seenMessageIds.find(msg.messageId) != seenMessageIds.end()) {
-        Serial.println("[MQTT] Duplicate message, ignoring: " + msg.messageId);
+        metrics.increment(CTR_MQTT_DUPLICATE);
+        LOG_TRACE("MQTT", "Duplicate message, ignoring: %s", msg.messageId.c_str());
         return;
     }
     seenMessageIds.insert(msg.messageId);
+    metrics.setGauge(GAUGE_SEEN_IDS, seenMessageIds.size());
     
     // Normalize our MAC for comparison
     String myMacStr = String(myMAC, HEX);
@@ -958,32 +980,30 @@ void MQTTMessenger::handleSyncRequest(const String& villageId, const uint8_t* pa
 }
 
 void MQTTMessenger::handleSyncResponse(const uint8_t* payload, unsigned int length) {
-    Serial.println("[MQTT] ============================================");
-    Serial.println("[MQTT] SYNC RESPONSE RECEIVED - length=" + String(length) + " bytes");
-    Serial.println("[MQTT] ============================================");
-    Serial.println("[MQTT] Decrypting sync response...");
-    logger.info("Sync response received: " + String(length) + " bytes");
+    LOG_TRACE("MQTT", "SYNC RESPONSE RECEIVED - length=%u bytes", length);
+    LOG_I("Sync response received: %u bytes", length);
     
     if (!encryption) {
-        Serial.println("[MQTT] No encryption set");
+        LOG_TRACE("MQTT", "No encryption set");
         return;
     }
     
     String message;
     if (!encryption->decryptString(payload, length, message)) {
-        Serial.println("[MQTT] Sync response decryption failed");
-        logger.error("Sync response decrypt failed");
+        metrics.increment(CTR_DECRYPT_FAILED);
+        LOG_TRACE("MQTT", "Sync response decryption failed");
+        LOG_E("Sync response decrypt failed");
         return;
     }
     
-    Serial.println("[MQTT] Decrypted sync response: " + message.substring(0, 100) + "...");
+    LOG_TRACE("MQTT", "Decrypted sync response: %.100s...", message.c_str());
     
     JsonDocument doc;
     DeserializationError error = deserializeJson(doc, message);
     
     if (error) {
-        Serial.println("[MQTT] Sync response parse error: " + String(error.c_str()));
-        logger.error("Sync response JSON error");
+        LOG_TRACE("MQTT", "Sync response parse error: %s", error.c_str());
+        LOG_E("Sync response JSON error");
         return;
     }
     
@@ -992,16 +1012,19 @@ void MQTTMessenger::handleSyncResponse(const uint8_t* payload, unsigned int leng
     int phase = doc["phase"] | 1;
     bool morePhases = doc["morePhases"] | false;
     
-    Serial.println("[MQTT] Sync phase " + String(phase) + " batch " + String(batch) + "/" + String(total));
-    logger.info("Sync phase " + String(phase) + " batch " + String(batch) + "/" + String(total));
+    LOG_TRACE("MQTT", "Sync phase %d batch %d/%d", phase, batch, total);
+    LOG_I("Sync phase %d batch %d/%d", phase, batch, total);
     
     // OPTIMIZATION: Set global sync flag to skip expensive status updates during sync
     // This is a global from main.cpp - forward declaration needed
     extern bool isSyncing;
+    if (batch == 1) {
+        syncPhaseStartUs = micros();
+    }
     if (batch == 1 && phase == 1) {
         isSyncing = true;  // Start of sync
         currentSyncPhase = 1;
-        Serial.println("[MQTT] Sync Phase 1 started (recent 20 messages) - disabling status updates");
+        LOG_TRACE("MQTT", "Sync Phase 1 started (recent 20 messages) - disabling status updates");
     }
     
     JsonArray msgArray = doc["messages"];
@@ -1025,17 +1048,16 @@ void MQTTMessenger::handleSyncResponse(const uint8_t* payload, unsigned int leng
         // Store sender MAC from first message for background sync continuation
         if (msgCount == 0 && batch == 1 && phase == 1 && !msg.senderMAC.isEmpty()) {
             syncTargetMAC = msg.senderMAC;
-            Serial.println("[MQTT] Stored sync target MAC: " + syncTargetMAC + " for background phases");
+            LOG_TRACE("MQTT", "Stored sync target MAC: %s for background phases", syncTargetMAC.c_str());
         }
         
         // CRITICAL: Send ACK for synced messages that are NOT ours
         // This ensures the sender gets delivery confirmation even if recipient was offline
         if (msg.senderMAC != myMacStr && !msg.messageId.isEmpty()) {
-            Serial.println("[MQTT] Sending ACK for synced message: " + msg.messageId);
-            Serial.println("[MQTT] DEBUG: senderMAC='" + msg.senderMAC + "' isEmpty=" + String(msg.senderMAC.isEmpty()));
-            Serial.println("[MQTT] DEBUG: villageId='" + msg.villageId + "'");
+            LOG_TRACE("MQTT", "Sending ACK for synced message: %s (senderMAC='%s', villageId='%s')",
+                      msg.messageId.c_str(), msg.senderMAC.c_str(), msg.villageId.c_str());
             if (msg.senderMAC.isEmpty()) {
-                Serial.println("[MQTT] ERROR: Cannot send ACK - senderMAC is empty!");
+                LOG_TRACE("MQTT", "ERROR: Cannot send ACK - senderMAC is empty!");
             } else {
                 sendAck(msg.messageId, msg.senderMAC, msg.villageId);
             }
@@ -1043,15 +1065,17 @@ void MQTTMessenger::handleSyncResponse(const uint8_t* payload, unsigned int leng
         
         // Deliver to app via message callback (deduplication happens in Village::saveMessage)
         if (onMessageReceived) {
-            Serial.println("[MQTT] Synced message: " + msg.messageId + " from " + msg.sender);
+            LOG_TRACE("MQTT", "Synced message: %s from %s", msg.messageId.c_str(), msg.sender.c_str());
             onMessageReceived(msg);
             msgCount++;
         }
     }
+    metrics.increment(CTR_SYNC_MESSAGES, msgCount);
     
     // End of phase
     if (batch == total) {
-        Serial.println("[MQTT] Phase " + String(phase) + " complete - processed " + String(msgCount) + " messages");
+        metrics.record(HIST_SYNC_PHASE, micros() - syncPhaseStartUs);
+        LOG_TRACE("MQTT", "Phase %d complete - processed %d messages", phase, msgCount);
         
         // ===== SYNC DEBUG: Trigger message store dump after phase completes =====
         extern void dumpMessageStoreDebug(int completedPhase);
@@ -1060,36 +1084,36 @@ void MQTTMessenger::handleSyncResponse(const uint8_t* payload, unsigned int leng
         if (phase == 1) {
             // Phase 1 complete - re-enable status updates, user has recent messages
             isSyncing = false;
-            Serial.println("[MQTT] Phase 1 complete - recent messages synced, re-enabled status updates");
-            logger.info("Phase 1 complete: " + String(msgCount) + " recent msgs");
+            LOG_TRACE("MQTT", "Phase 1 complete - recent messages synced, re-enabled status updates");
+            LOG_I("Phase 1 complete: %d recent msgs", msgCount);
             
             // Store sync state for background phase continuation
             if (morePhases) {
                 currentSyncPhase = 2;
                 lastSyncPhaseTime = millis();
-                Serial.println("[MQTT] More history available - will request Phase 2 in background after delay");
+                LOG_TRACE("MQTT", "More history available - will request Phase 2 in background after delay");
             } else {
                 currentSyncPhase = 0;  // All done
-                Serial.println("[MQTT] Sync fully complete - no more history");
+                LOG_TRACE("MQTT", "Sync fully complete - no more history");
             }
         } else {
             // Background phase complete
-            Serial.println("[MQTT] Background phase " + String(phase) + " complete");
-            logger.info("Phase " + String(phase) + " complete: " + String(msgCount) + " msgs");
+            LOG_TRACE("MQTT", "Background phase %d complete", phase);
+            LOG_I("Phase %d complete: %d msgs", phase, msgCount);
             
             if (morePhases) {
                 currentSyncPhase = phase + 1;
                 lastSyncPhaseTime = millis();
-                Serial.println("[MQTT] Will request Phase " + String(currentSyncPhase) + " in background");
+                LOG_TRACE("MQTT", "Will request Phase %d in background", currentSyncPhase);
             } else {
                 currentSyncPhase = 0;  // All history synced
-                Serial.println("[MQTT] All history synced");
+                LOG_TRACE("MQTT", "All history synced");
             }
         }
     }
     
-    Serial.println("[MQTT] Processed " + String(msgCount) + " synced messages in phase " + String(phase));
-    logger.info("Synced " + String(msgCount) + " messages");
+    LOG_TRACE("MQTT", "Processed %d synced messages in phase %d", msgCount, phase);
+    LOG_I("Synced %d messages", msgCount);
 }
 
 String MQTTMessenger::getConnectionStatus() {
@@ -1185,7 +1209,7 @@ void MQTTMessenger::subscribeToAllVillages() {
     subscribedVillages.clear();
     
     // Scan all village slots (0-9)
-    for (int slot = 0; slot < 10; slot++) {
+    for (int slot = 0; slot < MAX_VILLAGE_SLOTS; slot++) {
         if (Village::hasVillageInSlot(slot)) {
             Village tempVillage;
             if (tempVillage.loadFromSlot(slot)) {
@@ -1212,6 +1236,34 @@ VillageSubscription* MQTTMessenger::findVillageSubscription(const String& villag
     return nullptr;
 }
 
+// ============ Device Telemetry ============
+
+bool MQTTMessenger::publishStats(const String& payload) {
+    if (!connected || !mqttClient) {
+        LOG_E("Stats publish failed: not connected");
+        return false;
+    }
+    
+    char macStr[13];
+    sprintf(macStr, "%012llx", myMAC);
+    String topic = "smoltxt/" + String(macStr) + "/stats";
+    
+    // QoS 0, not retained - a lost snapshot is simply requested again
+    int msg_id = esp_mqtt_client_publish(mqttClient, topic.c_str(), payload.c_str(), payload.length(), 0, 0);
+    if (msg_id < 0) {
+        LOG_E("Stats publish failed");
+        return false;
+    }
+    
+    LOG_TRACE("MQTT", "Stats published to %s (%u bytes)", topic.c_str(), payload.length());
+    return true;
+}
+
+int MQTTMessenger::getOutboxSize() {
+    if (!mqttClient) return 0;
+    return esp_mqtt_client_get_outbox_size(mqttClient);
+}
+
 // ============ Invite Code Protocol ============
 
 bool MQTTMessenger::publishInvite(const String& inviteCode, const String& villageId, const String& villageName, const uint8_t* encryptionKey) {
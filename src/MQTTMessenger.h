@@ -52,6 +52,7 @@ private:
     unsigned long lastReconnectAttempt;
     unsigned long lastPingTime;
     bool connected;
+    bool sessionPresent;  // Broker resumed our persistent session (queued messages delivered)
     
     // Duplicate detection
     std::set<String> seenMessageIds;
@@ -61,6 +62,7 @@ private:
     int currentSyncPhase;  // 0 = not syncing, 1 = first 20, 2 = next 20, etc.
     String syncTargetMAC;   // MAC we're syncing with
     unsigned long lastSyncPhaseTime;  // Timestamp of last phase completion
+    uint32_t syncPhaseStartUs;        // micros() at batch 1 of the current phase (metrics)
     
     // Helper methods
     String generateMessageId();
@@ -123,8 +125,13 @@ public:
     bool requestSync(unsigned long lastMessageTimestamp);  // Request messages newer than timestamp
     bool sendSyncResponse(const String& targetMAC, const std::vector<Message>& messages, int phase = 1);  // Send messages to peer (phase 1 = recent 20, phase 2+ = older batches)
     
+    // Device telemetry (reply to the "stats" command) - plain JSON on smoltxt/<mac>/stats
+    bool publishStats(const String& payload);
+    int getOutboxSize();  // Publishes queued in the client, not yet acknowledged
+    
     // Connection status
     bool isConnected() { return connected && mqttClient != nullptr; }
+    bool hasSessionPresent() const { return sessionPresent; }  // True if nothing was missed while offline
     String getConnectionStatus();
     
     // Sync phase tracking (for UI decisions)
@@ -0,0 +1,97 @@
+#include "MessageHistory.h"
+
+MessageHistory::MessageHistory() {
+    clear();
+}
+
+void MessageHistory::clear() {
+    head = 0;
+    count = 0;
+    memset(senderRefs, 0, sizeof(senderRefs));
+    for (int i = 0; i < HISTORY_CAPACITY; i++) {
+        senders[i][0] = '\0';
+    }
+}
+
+uint8_t MessageHistory::internSender(const String& sender) {
+    int freeSlot = -1;
+
+    for (int i = 0; i < HISTORY_CAPACITY; i++) {
+        if (senderRefs[i] > 0) {
+            if (strncmp(senders[i], sender.c_str(), HISTORY_SENDER_LEN - 1) == 0) {
+                senderRefs[i]++;
+                return i;
+            }
+        } else if (freeSlot < 0) {
+            freeSlot = i;
+        }
+    }
+
+    // Table has one slot per entry, so a free slot always exists once the
+    // caller has evicted to make room
+    if (freeSlot < 0) freeSlot = 0;
+
+    strncpy(senders[freeSlot], sender.c_str(), HISTORY_SENDER_LEN - 1);
+    senders[freeSlot][HISTORY_SENDER_LEN - 1] = '\0';
+    senderRefs[freeSlot] = 1;
+    return freeSlot;
+}
+
+void MessageHistory::releaseSender(uint8_t index) {
+    if (index < HISTORY_CAPACITY && senderRefs[index] > 0) {
+        senderRefs[index]--;
+    }
+}
+
+void MessageHistory::fillEntry(HistoryEntry& entry, const Message& msg) {
+    entry.timestamp = msg.timestamp;
+    entry.senderIndex = internSender(msg.sender);
+    entry.received = msg.received;
+    entry.status = (uint8_t)msg.status;
+    entry.storeOffset = msg.storeOffset;
+
+    strncpy(entry.messageId, msg.messageId.c_str(), HISTORY_ID_LEN - 1);
+    entry.messageId[HISTORY_ID_LEN - 1] = '\0';
+
+    // Content longer than the slot is truncated (typed messages are far shorter)
+    strncpy(entry.content, msg.content.c_str(), HISTORY_CONTENT_LEN - 1);
+    entry.content[HISTORY_CONTENT_LEN - 1] = '\0';
+}
+
+bool MessageHistory::pushBack(const Message& msg) {
+    bool evicted = false;
+
+    if (count == HISTORY_CAPACITY) {
+        // Drop oldest
+        releaseSender(entries[head].senderIndex);
+        head = (head + 1) % HISTORY_CAPACITY;
+        count--;
+        evicted = true;
+    }
+
+    int slot = (head + count) % HISTORY_CAPACITY;
+    fillEntry(entries[slot], msg);
+    count++;
+    return evicted;
+}
+
+bool MessageHistory::pushFront(const Message& msg) {
+    bool evicted = false;
+
+    if (count == HISTORY_CAPACITY) {
+        // Drop newest
+        int newest = (head + count - 1) % HISTORY_CAPACITY;
+        releaseSender(entries[newest].senderIndex);
+        count--;
+        evicted = true;
+    }
+
+    head = (head + HISTORY_CAPACITY - 1) % HISTORY_CAPACITY;
+    fillEntry(entries[head], msg);
+    count++;
+    return evicted;
+}
+
+const HistoryEntry& MessageHistory::at(int index) const {
+    return entries[(head + index) % HISTORY_CAPACITY];
+}
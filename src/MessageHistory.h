@@ -0,0 +1,57 @@
+#ifndef MESSAGE_HISTORY_H
+#define MESSAGE_HISTORY_H
+
+#include <Arduino.h>
+#include "Messages.h"
+
+// Fixed-capacity window of messages for the messaging screen.
+// Entries live in a static ring buffer (no heap Strings), and sender names are
+// interned in a small table so a chatty sender costs one copy, not one per message.
+// The window can grow at either end: pushBack() for new arrivals, pushFront()
+// when older pages are loaded from the message store while scrolling up.
+
+#define HISTORY_CAPACITY 40         // Messages held in RAM at once
+#define HISTORY_CONTENT_LEN 192     // Max content bytes kept per message (incl. null)
+#define HISTORY_SENDER_LEN 32       // Matches MAX_USERNAME
+#define HISTORY_ID_LEN 40           // Message IDs are short hex/UUID strings
+
+struct HistoryEntry {
+    unsigned long timestamp;
+    uint8_t senderIndex;            // Index into interned sender table
+    bool received;
+    uint8_t status;                 // MessageStatus
+    uint32_t storeOffset;           // History cursor with timestamp (MESSAGE_OFFSET_UNKNOWN if unsaved)
+    char messageId[HISTORY_ID_LEN];
+    char content[HISTORY_CONTENT_LEN];
+};
+
+class MessageHistory {
+private:
+    HistoryEntry entries[HISTORY_CAPACITY];
+    int head;   // Ring index of oldest entry
+    int count;
+
+    // Interned sender names - one slot per possible distinct sender in the window
+    char senders[HISTORY_CAPACITY][HISTORY_SENDER_LEN];
+    uint8_t senderRefs[HISTORY_CAPACITY];
+
+    uint8_t internSender(const String& sender);
+    void releaseSender(uint8_t index);
+    void fillEntry(HistoryEntry& entry, const Message& msg);
+
+public:
+    MessageHistory();
+
+    void clear();
+    bool pushBack(const Message& msg);   // Append newest; evicts oldest when full. Returns true if evicted
+    bool pushFront(const Message& msg);  // Prepend older; evicts newest when full. Returns true if evicted
+
+    int size() const { return count; }
+    bool isFull() const { return count == HISTORY_CAPACITY; }
+    int capacity() const { return HISTORY_CAPACITY; }
+
+    const HistoryEntry& at(int index) const;  // 0 = oldest, size()-1 = newest
+    const char* senderOf(const HistoryEntry& entry) const { return senders[entry.senderIndex]; }
+};
+
+#endif
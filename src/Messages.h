@@ -26,6 +26,8 @@ enum MessageStatus {
     MSG_SEEN = 4  // Alias for MSG_READ for backwards compatibility
 };
 
+#define MESSAGE_OFFSET_UNKNOWN 0xFFFFFFFF
+
 // Message structure
 struct Message {
     String sender;
@@ -36,6 +38,7 @@ struct Message {
     MessageStatus status;
     String messageId;
     String villageId;  // Which village this message belongs to
+    uint32_t storeOffset = MESSAGE_OFFSET_UNKNOWN;  // Line offset in messages.dat (history cursor)
 };
 
 // Parsed message structure (for MQTT protocol parsing)
@@ -0,0 +1,201 @@
+#include "Metrics.h"
+
+Metrics metrics;
+
+// Upper bounds (inclusive) of every bucket but the last, which catches the rest
+const uint32_t Metrics::BUCKET_BOUNDS_US[METRIC_BUCKETS - 1] = {
+    50, 100, 250, 500,
+    1000, 2500, 5000, 10000, 25000,
+    100000, 500000, 2000000
+};
+
+const char* Metrics::COUNTER_NAMES[CTR_COUNT] = {
+    "mqtt_received",
+    "mqtt_duplicate",
+    "decrypt_failed",
+    "messages_saved",
+    "store_duplicate",
+    "sync_messages",
+    "display_partial",
+    "display_full",
+    "keys_dropped",
+    "keys_unhandled",
+    "keys_stale_repeat"
+};
+
+const char* Metrics::GAUGE_NAMES[GAUGE_COUNT] = {
+    "free_heap",
+    "min_free_heap",
+    "max_alloc_heap",
+    "seen_ids",
+    "boot_interactive_ms",
+    "boot_ready_ms"
+};
+
+const char* Metrics::HISTOGRAM_NAMES[HIST_COUNT] = {
+    "encrypt",
+    "decrypt",
+    "parse",
+    "save_message",
+    "load_messages",
+    "display_refresh",
+    "sync_phase",
+    "wifi_connect",
+    "key_queue",
+    "input_to_screen",
+    "input_line"
+};
+
+Metrics::Metrics() {
+    reset();
+}
+
+void Metrics::reset() {
+    for (int i = 0; i < CTR_COUNT; i++) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < GAUGE_COUNT; i++) {
+        gauges[i].store(0, std::memory_order_relaxed);
+    }
+    for (int h = 0; h < HIST_COUNT; h++) {
+        Histogram& hist = histograms[h];
+        for (int b = 0; b < METRIC_BUCKETS; b++) {
+            hist.buckets[b].store(0, std::memory_order_relaxed);
+        }
+        hist.count.store(0, std::memory_order_relaxed);
+        hist.sumUs.store(0, std::memory_order_relaxed);
+        hist.maxUs.store(0, std::memory_order_relaxed);
+    }
+    inputPendingUs.store(0, std::memory_order_relaxed);
+}
+
+void Metrics::markInput(uint32_t keyUs) {
+    // Keep the oldest - a burst of keys is measured from its first key
+    uint32_t expected = 0;
+    inputPendingUs.compare_exchange_strong(expected, keyUs ? keyUs : 1, std::memory_order_relaxed);
+}
+
+void Metrics::markScreenUpdated() {
+    uint32_t keyUs = inputPendingUs.exchange(0, std::memory_order_relaxed);
+    if (keyUs != 0) {
+        record(HIST_INPUT_TO_SCREEN, micros() - keyUs);
+    }
+}
+
+void Metrics::record(MetricHistogram hist, uint32_t us) {
+    Histogram& h = histograms[hist];
+
+    int bucket = 0;
+    while (bucket < METRIC_BUCKETS - 1 && us > BUCKET_BOUNDS_US[bucket]) {
+        bucket++;
+    }
+
+    h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.sumUs.fetch_add(us, std::memory_order_relaxed);
+
+    uint32_t seen = h.maxUs.load(std::memory_order_relaxed);
+    while (us > seen && !h.maxUs.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {
+        // seen reloaded by the failed CAS
+    }
+}
+
+void Metrics::refreshGauges() {
+    setGauge(GAUGE_FREE_HEAP, ESP.getFreeHeap());
+    setGauge(GAUGE_MIN_FREE_HEAP, ESP.getMinFreeHeap());
+    setGauge(GAUGE_MAX_ALLOC_HEAP, ESP.getMaxAllocHeap());
+}
+
+uint32_t Metrics::percentile(MetricHistogram hist, uint32_t total, int pct) const {
+    // Reported as the upper bound of the bucket holding the percentile - a
+    // histogram can't do better, and the max is printed alongside for the tail
+    uint32_t target = (total * pct + 99) / 100;
+    uint32_t cumulative = 0;
+    for (int b = 0; b < METRIC_BUCKETS - 1; b++) {
+        cumulative += histograms[hist].buckets[b].load(std::memory_order_relaxed);
+        if (cumulative >= target) return BUCKET_BOUNDS_US[b];
+    }
+    return histograms[hist].maxUs.load(std::memory_order_relaxed);
+}
+
+uint32_t Metrics::getAverage(MetricHistogram hist) const {
+    uint32_t total = getCount(hist);
+    if (total == 0) return 0;
+    return (uint32_t)(histograms[hist].sumUs.load(std::memory_order_relaxed) / total);
+}
+
+void Metrics::printDuration(Print& out, uint32_t us) {
+    if (us < 1000) {
+        out.printf("%uus", (unsigned)us);
+    } else if (us < 1000000) {
+        out.printf("%.1fms", us / 1000.0f);
+    } else {
+        out.printf("%.2fs", us / 1000000.0f);
+    }
+}
+
+void Metrics::printSnapshot(Print& out) {
+    refreshGauges();
+
+    out.println("=== METRICS ===");
+    out.printf("uptime: %lus\n", millis() / 1000);
+
+    out.println("-- counters --");
+    for (int i = 0; i < CTR_COUNT; i++) {
+        out.printf("%-18s %u\n", COUNTER_NAMES[i], (unsigned)getCounter((MetricCounter)i));
+    }
+
+    // Dedup hit rates - share of arrivals that were already known
+    uint32_t received = getCounter(CTR_MQTT_RECEIVED);
+    uint32_t dupes = getCounter(CTR_MQTT_DUPLICATE);
+    if (received > 0) {
+        out.printf("%-18s %.1f%%\n", "mqtt_dedup_rate", 100.0f * dupes / received);
+    }
+    uint32_t stored = getCounter(CTR_MESSAGES_SAVED) + getCounter(CTR_STORE_DUPLICATE);
+    if (stored > 0) {
+        out.printf("%-18s %.1f%%\n", "store_dedup_rate", 100.0f * getCounter(CTR_STORE_DUPLICATE) / stored);
+    }
+
+    out.println("-- gauges --");
+    for (int i = 0; i < GAUGE_COUNT; i++) {
+        out.printf("%-18s %d\n", GAUGE_NAMES[i], (int)getGauge((MetricGauge)i));
+    }
+
+    out.println("-- latency (count avg p50 p95 max) --");
+    for (int h = 0; h < HIST_COUNT; h++) {
+        uint32_t total = getCount((MetricHistogram)h);
+        out.printf("%-18s %u", HISTOGRAM_NAMES[h], (unsigned)total);
+        if (total > 0) {
+            out.print(" ");
+            printDuration(out, getAverage((MetricHistogram)h));
+            out.print(" ");
+            printDuration(out, percentile((MetricHistogram)h, total, 50));
+            out.print(" ");
+            printDuration(out, percentile((MetricHistogram)h, total, 95));
+            out.print(" ");
+            printDuration(out, histograms[h].maxUs.load(std::memory_order_relaxed));
+        }
+        out.println();
+    }
+    out.println("=== END METRICS ===");
+}
+
+void Metrics::toJson(JsonObject out) {
+    JsonObject ctr = out["ctr"].to<JsonObject>();
+    for (int i = 0; i < CTR_COUNT; i++) {
+        ctr[COUNTER_NAMES[i]] = getCounter((MetricCounter)i);
+    }
+
+    // Histograms as [count, avg, p50, p95, max] in microseconds - buckets stay on the device
+    JsonObject lat = out["lat"].to<JsonObject>();
+    for (int h = 0; h < HIST_COUNT; h++) {
+        uint32_t total = getCount((MetricHistogram)h);
+        if (total == 0) continue;
+        JsonArray row = lat[HISTOGRAM_NAMES[h]].to<JsonArray>();
+        row.add(total);
+        row.add(getAverage((MetricHistogram)h));
+        row.add(percentile((MetricHistogram)h, total, 50));
+        row.add(percentile((MetricHistogram)h, total, 95));
+        row.add(histograms[h].maxUs.load(std::memory_order_relaxed));
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+
+// Monotonic event counters
+enum MetricCounter {
+    CTR_MQTT_RECEIVED = 0,   // Decrypted village messages seen by the MQTT task
+    CTR_MQTT_DUPLICATE,      // ...of those, dropped by the seen-ID filter
+    CTR_DECRYPT_FAILED,
+    CTR_MESSAGES_SAVED,      // New lines appended to messages.dat
+    CTR_STORE_DUPLICATE,     // saveMessage() calls skipped - ID already in the store
+    CTR_SYNC_MESSAGES,       // Messages delivered by sync responses
+    CTR_DISPLAY_PARTIAL,
+    CTR_DISPLAY_FULL,
+    CTR_KEYS_DROPPED,        // Key queue full - events lost
+    CTR_KEYS_UNHANDLED,      // Special keys no screen handler consumed
+    CTR_KEYS_STALE_REPEAT,   // Held-key repeats skipped because the handler fell behind
+    CTR_COUNT
+};
+
+// Point-in-time values (last write wins)
+enum MetricGauge {
+    GAUGE_FREE_HEAP = 0,
+    GAUGE_MIN_FREE_HEAP,
+    GAUGE_MAX_ALLOC_HEAP,    // Largest free block
+    GAUGE_SEEN_IDS,          // Size of the MQTT dedup set
+    GAUGE_BOOT_INTERACTIVE_MS,  // millis() when setup() handed the UI to loop()
+    GAUGE_BOOT_READY_MS,        // millis() when the deferred boot stages finished
+    GAUGE_COUNT
+};
+
+// Latency histograms, all in microseconds
+enum MetricHistogram {
+    HIST_ENCRYPT = 0,
+    HIST_DECRYPT,
+    HIST_PARSE,              // Wire-format parse of a decrypted message
+    HIST_SAVE_MESSAGE,       // Village::saveMessage() flash append
+    HIST_LOAD_MESSAGES,      // Village::loadMessages() / loadMessageRange()
+    HIST_DISPLAY_REFRESH,    // Panel refresh (partial and full)
+    HIST_SYNC_PHASE,         // First to last batch of one sync phase
+    HIST_WIFI_CONNECT,       // WiFi.begin() to associated, successful attempts only
+    HIST_KEY_QUEUE,          // Key read from the CardKB to consumed by a handler
+    HIST_INPUT_TO_SCREEN,    // Oldest consumed key to the end of the next panel refresh
+    HIST_INPUT_LINE,         // UI::updateInputLine() - draw, SPI transfer and panel update
+    HIST_COUNT
+};
+
+#define METRIC_BUCKETS 13    // Fixed bounds, see Metrics.cpp - last bucket is overflow
+
+// Counters, gauges and fixed-bucket histograms across subsystems.
+// Everything is a relaxed atomic so the MQTT task and loop() can record without
+// locks; a snapshot is only approximately consistent, which is fine for telemetry.
+// Read it over serial with !METRICS (see Logger::update).
+class Metrics {
+private:
+    struct Histogram {
+        std::atomic<uint32_t> buckets[METRIC_BUCKETS];
+        std::atomic<uint32_t> count;
+        std::atomic<uint64_t> sumUs;
+        std::atomic<uint32_t> maxUs;
+    };
+
+    static const uint32_t BUCKET_BOUNDS_US[METRIC_BUCKETS - 1];
+    static const char* COUNTER_NAMES[CTR_COUNT];
+    static const char* GAUGE_NAMES[GAUGE_COUNT];
+    static const char* HISTOGRAM_NAMES[HIST_COUNT];
+
+    std::atomic<uint32_t> counters[CTR_COUNT];
+    std::atomic<int32_t> gauges[GAUGE_COUNT];
+    Histogram histograms[HIST_COUNT];
+    std::atomic<uint32_t> inputPendingUs;  // Oldest key not yet on screen, 0 = none
+
+    uint32_t percentile(MetricHistogram hist, uint32_t total, int pct) const;
+    static void printDuration(Print& out, uint32_t us);
+
+public:
+    Metrics();
+
+    void increment(MetricCounter counter, uint32_t amount = 1) {
+        counters[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+    void setGauge(MetricGauge gauge, int32_t value) {
+        gauges[gauge].store(value, std::memory_order_relaxed);
+    }
+    void record(MetricHistogram hist, uint32_t us);
+
+    // Input-to-screen latency: a handler consumed a key read at keyUs, and the
+    // next panel refresh shows its effect
+    void markInput(uint32_t keyUs);
+    void markScreenUpdated();
+
+    uint32_t getCounter(MetricCounter counter) const { return counters[counter].load(std::memory_order_relaxed); }
+    int32_t getGauge(MetricGauge gauge) const { return gauges[gauge].load(std::memory_order_relaxed); }
+    uint32_t getCount(MetricHistogram hist) const { return histograms[hist].count.load(std::memory_order_relaxed); }
+    uint32_t getAverage(MetricHistogram hist) const;  // Microseconds, 0 if nothing recorded
+
+    void refreshGauges();           // Sample heap gauges
+    void printSnapshot(Print& out);
+    void toJson(JsonObject out);    // Compact form for remote telemetry
+    void reset();
+};
+
+extern Metrics metrics;
+
+// Records the lifetime of a scope into a histogram:
+//   { MetricTimer timer(HIST_SAVE_MESSAGE); ... }
+class MetricTimer {
+private:
+    MetricHistogram hist;
+    uint32_t startUs;
+
+public:
+    explicit MetricTimer(MetricHistogram hist) : hist(hist), startUs(micros()) {}
+    ~MetricTimer() { metrics.record(hist, micros() - startUs); }
+};
+
+#endif
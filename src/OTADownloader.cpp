@@ -0,0 +1,438 @@
+#include "OTADownloader.h"
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <esp_ota_ops.h>
+
+#define OTA_RESUME_NAMESPACE "ota_resume"
+
+OTADownloader::OTADownloader() {
+    chunks = nullptr;
+    freeChunks = nullptr;
+    fullChunks = nullptr;
+    writerTask = nullptr;
+    writerExited = nullptr;
+    writerRunning = false;
+    writeFailed = false;
+    target = nullptr;
+    written = 0;
+    queued = 0;
+    totalSize = 0;
+    progressCallback = nullptr;
+}
+
+bool OTADownloader::fail(const String& reason) {
+    error = reason;
+    Serial.println("[OTA] Download failed: " + reason);
+    return false;
+}
+
+void OTADownloader::clearResumeState() {
+    Preferences resume;
+    resume.begin(OTA_RESUME_NAMESPACE, false);
+    resume.clear();
+    resume.end();
+}
+
+bool OTADownloader::download(const String& downloadUrl, const String& sha256Hex,
+                             void (*progress)(int progress, int total)) {
+    url = downloadUrl;
+    expectedHash = sha256Hex;
+    expectedHash.toLowerCase();
+    progressCallback = progress;
+    error = "";
+    if (writerRunning) {
+        // A previous writer never came back from a flash operation - it still owns the
+        // hash context and may still touch the partition
+        return fail("previous flash write still running - restart to retry");
+    }
+    writeFailed = false;
+
+    target = esp_ota_get_next_update_partition(NULL);
+    if (!target) {
+        return fail("no OTA partition");
+    }
+
+    prefs.begin(OTA_RESUME_NAMESPACE, false);
+    mbedtls_sha256_init(&hash);
+    mbedtls_sha256_starts(&hash, 0);
+
+    // Continue a previous attempt at this same image - the prefix on flash is re-hashed,
+    // which both rebuilds the digest state and checks the sectors are still intact
+    uint32_t offset = loadResumeOffset();
+    if (offset > 0) {
+        Serial.println("[OTA] Resuming at " + String(offset) + "/" + String(totalSize) + " bytes");
+        if (!rehashPrefix(offset)) {
+            restartFromZero();
+            offset = 0;
+        }
+    }
+    written = offset;
+    queued = offset;
+
+    if (!startWriter()) {
+        prefs.end();
+        return fail("out of memory");
+    }
+
+    bool complete = false;
+    for (int attempt = 0; attempt <= OTA_MAX_RESUMES; attempt++) {
+        if (attempt > 0) {
+            unsigned long waitStart = millis();
+            while (WiFi.status() != WL_CONNECTED && millis() - waitStart < OTA_WIFI_WAIT) {
+                delay(250);
+            }
+            Serial.println("[OTA] Connection lost - resuming at " + String(queued) + " bytes (attempt " +
+                           String(attempt) + "/" + String(OTA_MAX_RESUMES) + ")");
+        }
+
+        if (fetchFrom(queued)) {
+            complete = true;
+            break;
+        }
+        if (error.length() > 0) break;  // Hard failure - retrying won't help
+    }
+
+    bool drained = drainWriter();
+    bool stopped = stopWriter();
+
+    if (writeFailed) {
+        fail("flash write failed");
+    } else if (!drained || !stopped) {
+        fail("writer task stalled");
+    }
+    if (!complete || writeFailed || !drained || !stopped) {
+        // Keep the checkpoint - the next attempt picks up from the last written chunk
+        if (stopped) mbedtls_sha256_free(&hash);  // A stuck writer may still hash into it
+        prefs.end();
+        if (error.length() == 0) error = "connection lost";
+        return false;
+    }
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&hash, digest);
+    mbedtls_sha256_free(&hash);
+    prefs.end();
+
+    char hex[65];
+    for (int i = 0; i < 32; i++) {
+        sprintf(hex + i * 2, "%02x", digest[i]);
+    }
+    Serial.println("[OTA] Image SHA-256: " + String(hex));
+
+    if (expectedHash.length() > 0 && expectedHash != hex) {
+        clearResumeState();
+        return fail("SHA-256 mismatch (expected " + expectedHash + ")");
+    }
+
+    // Validates the image header and checksums before switching
+    esp_err_t err = esp_ota_set_boot_partition(target);
+    clearResumeState();
+    if (err != ESP_OK) {
+        return fail("image rejected: " + String(esp_err_to_name(err)));
+    }
+
+    Serial.println("[OTA] Boot partition set to " + String(target->label));
+    return true;
+}
+
+uint32_t OTADownloader::loadResumeOffset() {
+    String savedUrl = prefs.getString("url", "");
+    String savedPartition = prefs.getString("part", "");
+    String savedHash = prefs.getString("sha", "");
+    uint32_t offset = prefs.getUInt("offset", 0);
+    totalSize = prefs.getUInt("total", 0);
+    etag = prefs.getString("etag", "");
+
+    if (savedUrl == url && savedHash == expectedHash && savedPartition == target->label &&
+        offset > 0 && offset % OTA_CHUNK_SIZE == 0 && offset < totalSize) {
+        return offset;
+    }
+
+    // Different image (or nothing saved) - start a fresh record
+    prefs.clear();
+    prefs.putString("url", url);
+    prefs.putString("part", target->label);
+    prefs.putString("sha", expectedHash);
+    totalSize = 0;
+    etag = "";
+    return 0;
+}
+
+void OTADownloader::saveCheckpoint() {
+    prefs.putUInt("offset", written);
+}
+
+bool OTADownloader::rehashPrefix(uint32_t length) {
+    uint8_t* buffer = (uint8_t*)malloc(OTA_CHUNK_SIZE);
+    if (!buffer) return false;
+
+    bool ok = true;
+    for (uint32_t pos = 0; pos < length; pos += OTA_CHUNK_SIZE) {
+        uint32_t n = min((uint32_t)OTA_CHUNK_SIZE, length - pos);
+        if (esp_partition_read(target, pos, buffer, n) != ESP_OK) {
+            ok = false;
+            break;
+        }
+        mbedtls_sha256_update(&hash, buffer, n);
+    }
+    free(buffer);
+    return ok;
+}
+
+void OTADownloader::restartFromZero() {
+    mbedtls_sha256_free(&hash);
+    mbedtls_sha256_init(&hash);
+    mbedtls_sha256_starts(&hash, 0);
+    written = 0;
+    queued = 0;
+    etag = "";
+    prefs.putUInt("offset", 0);
+    prefs.remove("etag");
+}
+
+bool OTADownloader::startWriter() {
+    chunks = (Chunk*)malloc(sizeof(Chunk) * OTA_BUFFERS);
+    freeChunks = xQueueCreate(OTA_BUFFERS, sizeof(uint8_t));
+    fullChunks = xQueueCreate(OTA_BUFFERS + 1, sizeof(uint8_t));  // + the exit marker
+    writerExited = xSemaphoreCreateBinary();
+    if (!chunks || !freeChunks || !fullChunks || !writerExited) {
+        stopWriter();
+        return false;
+    }
+
+    for (uint8_t i = 0; i < OTA_BUFFERS; i++) {
+        xQueueSend(freeChunks, &i, 0);
+    }
+
+    writerRunning = true;
+    if (xTaskCreate(writerTaskEntry, "otawrite", 6144, this, 2, &writerTask) != pdPASS) {
+        writerTask = nullptr;
+        writerRunning = false;
+        stopWriter();
+        return false;
+    }
+    return true;
+}
+
+bool OTADownloader::stopWriter() {
+    if (writerTask) {
+        // Never vTaskDelete() the writer from here - mid esp_partition_write it holds the
+        // flash lock and its buffer would be freed underneath it. Queue the exit marker
+        // behind any pending chunks and let it leave on its own
+        uint8_t exitIndex = OTA_WRITER_EXIT;
+        bool exited = xQueueSend(fullChunks, &exitIndex, 0) == pdTRUE &&
+                      xSemaphoreTake(writerExited, pdMS_TO_TICKS(OTA_STALL_TIMEOUT)) == pdTRUE;
+        if (!exited) {
+            // Stuck in a flash operation - it keeps its queues and buffers until restart
+            Serial.println("[OTA] Writer task did not stop - leaving it running");
+            writerTask = nullptr;
+            writerExited = nullptr;
+            freeChunks = nullptr;
+            fullChunks = nullptr;
+            chunks = nullptr;
+            return false;
+        }
+        writerTask = nullptr;  // Deleted itself
+    }
+    if (freeChunks) vQueueDelete(freeChunks);
+    if (fullChunks) vQueueDelete(fullChunks);
+    if (writerExited) vSemaphoreDelete(writerExited);
+    free(chunks);
+    freeChunks = nullptr;
+    fullChunks = nullptr;
+    writerExited = nullptr;
+    chunks = nullptr;
+    return true;
+}
+
+bool OTADownloader::drainWriter() {
+    uint8_t indices[OTA_BUFFERS];
+    int returned = 0;
+    while (returned < OTA_BUFFERS &&
+           xQueueReceive(freeChunks, &indices[returned], pdMS_TO_TICKS(OTA_STALL_TIMEOUT)) == pdTRUE) {
+        returned++;
+    }
+    for (int i = 0; i < returned; i++) {
+        xQueueSend(freeChunks, &indices[i], 0);
+    }
+    return returned == OTA_BUFFERS;
+}
+
+void OTADownloader::writerTaskEntry(void* param) {
+    static_cast<OTADownloader*>(param)->writerLoop();
+}
+
+void OTADownloader::writerLoop() {
+    // Own copies - stopWriter() drops the members when it has to leave this task behind
+    Chunk* buffers = chunks;
+    QueueHandle_t full = fullChunks;
+    QueueHandle_t empty = freeChunks;
+    SemaphoreHandle_t exited = writerExited;
+
+    uint8_t index;
+    while (xQueueReceive(full, &index, portMAX_DELAY) == pdTRUE) {
+        if (index == OTA_WRITER_EXIT) break;
+        Chunk& chunk = buffers[index];
+
+        if (!writeFailed) {
+            // Chunks start on a sector boundary, so each one owns exactly one sector
+            if (esp_partition_erase_range(target, chunk.offset, OTA_CHUNK_SIZE) != ESP_OK ||
+                esp_partition_write(target, chunk.offset, chunk.data, chunk.length) != ESP_OK) {
+                writeFailed = true;
+            } else {
+                mbedtls_sha256_update(&hash, chunk.data, chunk.length);
+                written = chunk.offset + chunk.length;
+                if (written % OTA_CHECKPOINT_BYTES == 0) {
+                    saveCheckpoint();
+                }
+            }
+        }
+
+        xQueueSend(empty, &index, portMAX_DELAY);
+    }
+
+    writerRunning = false;
+    xSemaphoreGive(exited);
+    vTaskDelete(NULL);
+}
+
+bool OTADownloader::fetchFrom(uint32_t offset) {
+    bool secure = url.startsWith("https://");
+    WiFiClientSecure secureClient;
+    WiFiClient plainClient;
+    if (secure) {
+        secureClient.setInsecure();  // Skip certificate validation for GitHub (image is hash-checked)
+    }
+
+    HTTPClient http;
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);  // Release assets redirect to the CDN
+    http.setTimeout(OTA_STALL_TIMEOUT);
+    if (!http.begin(secure ? (WiFiClient&)secureClient : plainClient, url)) {
+        return fail("bad URL: " + url);
+    }
+    http.addHeader("User-Agent", "SmolTxt-OTA");
+    if (offset > 0) {
+        http.addHeader("Range", "bytes=" + String(offset) + "-");
+        if (etag.length() > 0) {
+            // Only honour the range if it's still the same file - otherwise send all of it
+            http.addHeader("If-Range", etag);
+        }
+    }
+    const char* headerKeys[] = {"Content-Range", "ETag"};
+    http.collectHeaders(headerKeys, 2);
+
+    int httpCode = http.GET();
+    if (httpCode < 0) {
+        // Connection-level failure - worth another attempt
+        Serial.println("[OTA] Request failed: " + http.errorToString(httpCode));
+        http.end();
+        return false;
+    }
+
+    if (httpCode == HTTP_CODE_PARTIAL_CONTENT && offset > 0) {
+        // Content-Range: bytes <start>-<end>/<total>
+        String range = http.header("Content-Range");
+        unsigned int start = 0, end = 0, total = 0;
+        if (sscanf(range.c_str(), "bytes %u-%u/%u", &start, &end, &total) != 3 || start != offset) {
+            http.end();
+            return fail("bad Content-Range: " + range);
+        }
+        // A server that ignores If-Range still gives the change away by size or ETag
+        String responseEtag = http.header("ETag");
+        if ((totalSize > 0 && total != totalSize) ||
+            (etag.length() > 0 && responseEtag.length() > 0 && responseEtag != etag)) {
+            Serial.println("[OTA] Image at the URL changed since the checkpoint - restarting download");
+            http.end();
+            if (!drainWriter()) {
+                return fail("writer task stalled");
+            }
+            restartFromZero();
+            return false;  // Next attempt fetches from byte zero
+        }
+        totalSize = total;
+    } else if (httpCode == HTTP_CODE_OK) {
+        if (offset > 0) {
+            // Server ignored the Range header, or If-Range saw a different file - the
+            // body starts at byte zero again
+            Serial.println("[OTA] Server sent the whole image - restarting download");
+            if (!drainWriter()) {
+                http.end();
+                return fail("writer task stalled");
+            }
+            restartFromZero();
+        }
+        int size = http.getSize();
+        if (size <= 0) {
+            http.end();
+            return fail("server did not send the image size");
+        }
+        totalSize = size;
+        etag = http.header("ETag");
+        prefs.putString("etag", etag);
+    } else {
+        http.end();
+        return fail("HTTP " + String(httpCode));
+    }
+
+    if (totalSize > target->size) {
+        http.end();
+        return fail("image larger than partition");
+    }
+    prefs.putUInt("total", totalSize);
+
+    WiFiClient* stream = http.getStreamPtr();
+    Chunk* chunk = nullptr;
+    uint8_t index = 0;
+    unsigned long lastData = millis();
+
+    while (queued < totalSize) {
+        if (writeFailed) {
+            if (chunk) xQueueSend(freeChunks, &index, 0);
+            http.end();
+            return fail("flash write failed");
+        }
+
+        if (!chunk) {
+            // Blocks only while both buffers are with the writer - flash is the bottleneck
+            if (xQueueReceive(freeChunks, &index, pdMS_TO_TICKS(OTA_STALL_TIMEOUT)) != pdTRUE) {
+                http.end();
+                return fail("writer task stalled");
+            }
+            chunk = &chunks[index];
+            chunk->offset = queued;
+            chunk->length = 0;
+        }
+
+        size_t available = stream->available();
+        if (available == 0) {
+            if (!http.connected() || millis() - lastData > OTA_STALL_TIMEOUT) {
+                // Dropped - the partial chunk is discarded, the resume starts at its offset
+                xQueueSend(freeChunks, &index, 0);
+                http.end();
+                return false;
+            }
+            delay(1);
+            continue;
+        }
+
+        size_t room = min((size_t)(OTA_CHUNK_SIZE - chunk->length), (size_t)(totalSize - queued - chunk->length));
+        int n = stream->readBytes(chunk->data + chunk->length, min(available, room));
+        if (n <= 0) continue;
+        lastData = millis();
+        chunk->length += n;
+
+        if (chunk->length == OTA_CHUNK_SIZE || queued + chunk->length == totalSize) {
+            queued += chunk->length;
+            xQueueSend(fullChunks, &index, portMAX_DELAY);
+            chunk = nullptr;
+
+            if (progressCallback) {
+                progressCallback(queued, totalSize);
+            }
+        }
+    }
+
+    http.end();
+    return true;
+}
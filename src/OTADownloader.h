@@ -0,0 +1,82 @@
+#ifndef OTA_DOWNLOADER_H
+#define OTA_DOWNLOADER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+
+#define OTA_CHUNK_SIZE 4096           // One flash sector per buffer - chunks start sector-aligned
+#define OTA_BUFFERS 2                 // Network fills one while the writer task programs the other
+#define OTA_CHECKPOINT_BYTES 65536    // Written offset persisted to NVS this often
+#define OTA_MAX_RESUMES 5             // Range-resumes per download() before giving up
+#define OTA_STALL_TIMEOUT 15000       // No bytes for this long = connection dropped
+#define OTA_WIFI_WAIT 20000           // Wait for the link to come back before resuming
+#define OTA_WRITER_EXIT 0xFF          // Queued after the last chunk - the writer finishes and exits
+
+// Full-image OTA that survives a dropped connection. The image is written straight to
+// the inactive app partition in sector-sized chunks: a writer task erases/programs one
+// chunk while the next is read from the network, and hashes what it wrote. The written
+// offset is checkpointed in NVS, so a later attempt (same session or after a reboot)
+// re-hashes the prefix already on flash and continues with an HTTP Range request.
+// The checkpoint is tied to the URL, the expected SHA-256 and the server's ETag/size:
+// a fixed URL (releases/latest/...) can start serving a different file between attempts,
+// and its bytes must never be spliced onto the old prefix.
+// The slot is only made bootable once the SHA-256 matches (when one is published) and
+// the bootloader's image check passes.
+//
+// http:// URLs use a plain client, so tools/ota_test_server.py can stand in for GitHub.
+class OTADownloader {
+private:
+    struct Chunk {
+        uint32_t offset;              // Absolute offset in the partition
+        size_t length;
+        uint8_t data[OTA_CHUNK_SIZE];
+    };
+
+    Chunk* chunks;
+    QueueHandle_t freeChunks;         // Indices the network side may fill
+    QueueHandle_t fullChunks;         // Indices waiting for the writer task
+    TaskHandle_t writerTask;
+    SemaphoreHandle_t writerExited;   // Given by the writer right before it deletes itself
+    volatile bool writerRunning;      // False once the writer has exited, even a leaked one
+    volatile bool writeFailed;
+
+    const esp_partition_t* target;
+    Preferences prefs;
+    mbedtls_sha256_context hash;      // Over bytes written, in order (writer task)
+    volatile uint32_t written;        // Bytes programmed and hashed
+    uint32_t queued;                  // Bytes handed to the writer (network side)
+    uint32_t totalSize;
+
+    String url;
+    String expectedHash;              // Lowercase hex, empty = rely on the image check only
+    String etag;                      // Validator of the image being resumed, empty = none sent
+    String error;
+    void (*progressCallback)(int progress, int total);
+
+    bool startWriter();
+    bool stopWriter();                // False = writer stuck in a flash op, left running (leaked)
+    bool drainWriter();               // Wait until every buffer is back from the writer
+    static void writerTaskEntry(void* param);
+    void writerLoop();
+
+    uint32_t loadResumeOffset();
+    void saveCheckpoint();
+    bool rehashPrefix(uint32_t length);
+    void restartFromZero();
+
+    bool fetchFrom(uint32_t offset);  // One HTTP connection; false = dropped or failed
+    bool fail(const String& reason);
+
+public:
+    OTADownloader();
+
+    // Blocking. Downloads, verifies and sets the boot partition - true = restart into it
+    bool download(const String& url, const String& sha256Hex, void (*progress)(int progress, int total));
+
+    static void clearResumeState();   // E.g. before something else writes the inactive slot
+    const String& getError() const { return error; }
+};
+
+#endif
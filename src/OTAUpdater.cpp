@@ -1,4 +1,6 @@
 #include "OTAUpdater.h"
+#include "DeltaPatcher.h"
+#include "OTADownloader.h"
 #include <Update.h>
 #include <esp_ota_ops.h>
 
@@ -10,10 +12,14 @@ OTAUpdater::OTAUpdater() {
     currentVersion = FIRMWARE_VERSION;
     latestVersion = "";
     downloadURL = "";
+    downloadHash = "";
+    deltaURL = "";
+    deltaSize = 0;
     releaseNotes = "";
     githubOwner = "";
     githubRepo = "";
     customURL = "";
+    minCheckInterval = OTA_DEFAULT_CHECK_INTERVAL;
     progressCallback = nullptr;
     instance = this;
 }
@@ -67,7 +73,7 @@ void OTAUpdater::setCustomURL(const String& url) {
     Serial.println("[OTA] Update source: " + url);
 }
 
-bool OTAUpdater::checkForUpdate() {
+bool OTAUpdater::checkForUpdate(bool force) {
     if (WiFi.status() != WL_CONNECTED) {
         if (logger) logger->error("OTA check failed: no WiFi");
         Serial.println("[OTA] No WiFi connection");
@@ -79,11 +85,27 @@ bool OTAUpdater::checkForUpdate() {
     Serial.println("[OTA] Checking for updates...");
     
     if (githubOwner.length() > 0 && githubRepo.length() > 0) {
+        // Checked recently - answer from the cached manifest, no TLS handshake at all
+        if (!force && loadCachedManifest(true)) {
+            return reportLatest();
+        }
+        
+        int result = fetchManifest();
+        if (result == MANIFEST_OK) {
+            return reportLatest();
+        }
+        if (result == MANIFEST_UNCHANGED && loadCachedManifest(false)) {
+            Serial.println("[OTA] Manifest unchanged (304)");
+            return reportLatest();
+        }
+        
+        // Release without a manifest (or fetch failed) - fall back to the API
         return fetchLatestRelease();
     } else if (customURL.length() > 0) {
         // For custom URL, assume URL points directly to firmware.bin
         // and a version.json file exists at same location
         downloadURL = customURL;
+        downloadHash = fetchSidecarHash(customURL + ".sha256");
         latestVersion = "custom";
         status = UPDATE_AVAILABLE;
         return true;
@@ -113,12 +135,18 @@ bool OTAUpdater::fetchLatestRelease() {
         return false;
     }
     
-    String payload = http.getString();
-    http.end();
+    // Parse straight from the stream, keeping only the fields we use - release
+    // notes and most asset metadata are skipped instead of buffered
+    JsonDocument filter;
+    filter["tag_name"] = true;
+    filter["assets"][0]["name"] = true;
+    filter["assets"][0]["browser_download_url"] = true;
+    filter["assets"][0]["size"] = true;
+    filter["assets"][0]["digest"] = true;
     
-    // Parse JSON response
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
+    DeserializationError error = deserializeJson(doc, http.getStream(), DeserializationOption::Filter(filter));
+    http.end();
     
     if (error) {
         if (logger) logger->error("OTA JSON parse failed");
@@ -129,16 +157,30 @@ bool OTAUpdater::fetchLatestRelease() {
     
     // Extract version and download URL
     latestVersion = doc["tag_name"].as<String>();
-    releaseNotes = doc["body"].as<String>();
+    releaseNotes = "";  // Not fetched (filtered out above)
     
-    // Find firmware.bin asset
+    // Find firmware.bin asset, and a delta patch built against the version we run
+    String deltaName = "firmware-delta-" + currentVersion + ".patch";
+    downloadURL = "";
+    downloadHash = "";
+    deltaURL = "";
+    deltaSize = 0;
     JsonArray assets = doc["assets"];
     for (JsonVariant asset : assets) {
         String assetName = asset["name"].as<String>();
-        if (assetName.endsWith(".bin")) {
+        if (assetName.endsWith(".bin") && downloadURL.length() == 0) {
             downloadURL = asset["browser_download_url"].as<String>();
             Serial.println("[OTA] Download URL: " + downloadURL);
-            break;
+            
+            // GitHub publishes "sha256:<hex>" per asset - verified after download
+            String digest = asset["digest"] | "";
+            if (digest.startsWith("sha256:")) {
+                downloadHash = digest.substring(7);
+            }
+        } else if (assetName == deltaName) {
+            deltaURL = asset["browser_download_url"].as<String>();
+            deltaSize = asset["size"] | 0;
+            Serial.println("[OTA] Delta URL: " + deltaURL + " (" + String(deltaSize) + " bytes)");
         }
     }
     
@@ -149,6 +191,12 @@ bool OTAUpdater::fetchLatestRelease() {
         return false;
     }
     
+    // Cache it like a manifest, so the check interval applies to this path too
+    storeManifest("", latestVersion, downloadHash, deltaURL.length() > 0 ? currentVersion : "", deltaSize);
+    return reportLatest();
+}
+
+bool OTAUpdater::reportLatest() {
     // Compare versions
     Serial.println("[OTA] Current: " + currentVersion + ", Latest: " + latestVersion);
     
@@ -165,6 +213,192 @@ bool OTAUpdater::fetchLatestRelease() {
     }
 }
 
+// manifest.txt, published with each release (see release.ps1) - a few lines of key=value:
+//   version=v0.56.22
+//   size=1245024
+//   sha256=<hex of firmware-v0.56.22.bin>
+//   delta=v0.56.21          (optional: firmware-delta-v0.56.21.patch is published too)
+//   delta_size=32637
+// Fetched from the stable latest-release URL with If-None-Match, and parsed line by
+// line off the stream - at most MANIFEST_MAX_BYTES of it, whatever the headers claim.
+int OTAUpdater::fetchManifest() {
+    String manifestURL = "https://github.com/" + githubOwner + "/" + githubRepo + "/releases/latest/download/manifest.txt";
+    
+    Preferences prefs;
+    prefs.begin(OTA_CHECK_NAMESPACE, false);
+    String etag = prefs.getString("etag", "");
+    
+    WiFiClientSecure client;
+    client.setInsecure();  // Versions only - the image itself is hash-verified
+    HTTPClient http;
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);  // latest/download redirects to the CDN
+    http.setReuse(false);  // One request - don't hold the socket open for keep-alive
+    http.useHTTP10(true);  // No chunked encoding, so the raw stream is the body
+    http.begin(client, manifestURL);
+    http.addHeader("User-Agent", "SmolTxt-OTA");
+    if (etag.length() > 0) {
+        http.addHeader("If-None-Match", etag);
+    }
+    const char* headerKeys[] = {"ETag"};
+    http.collectHeaders(headerKeys, 1);
+    
+    Serial.println("[OTA] Fetching manifest: " + manifestURL);
+    int httpCode = http.GET();
+    
+    if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+        http.end();
+        prefs.putUInt("checked", (uint32_t)time(nullptr));
+        prefs.end();
+        return MANIFEST_UNCHANGED;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.println("[OTA] Manifest fetch failed, code: " + String(httpCode));
+        http.end();
+        prefs.end();
+        return MANIFEST_FAILED;
+    }
+    
+    // The body is a few short lines. Stop at Content-Length when there is one, otherwise
+    // when the server closes (HTTP/1.0) - and never buffer more than MANIFEST_MAX_BYTES
+    int size = http.getSize();  // -1 = not announced
+    if (size > MANIFEST_MAX_BYTES) {
+        Serial.println("[OTA] Manifest too large: " + String(size) + " bytes");
+        http.end();
+        prefs.end();
+        return MANIFEST_FAILED;
+    }
+    String newEtag = http.header("ETag");
+    
+    WiFiClient* stream = http.getStreamPtr();
+    String version, sha, delta;
+    int dSize = 0;
+    String line;
+    int received = 0;
+    int lines = 0;
+    bool tooLarge = false;
+    unsigned long lastData = millis();
+    while (lines < MANIFEST_MAX_LINES) {
+        bool endOfBody = (size >= 0 && received >= size);
+        int c = -1;
+        if (!endOfBody) {
+            if (!stream->available()) {
+                if (!http.connected() || millis() - lastData > MANIFEST_READ_TIMEOUT) {
+                    endOfBody = true;
+                } else {
+                    delay(10);
+                    continue;
+                }
+            } else {
+                c = stream->read();
+                lastData = millis();
+                if (++received > MANIFEST_MAX_BYTES) {
+                    tooLarge = true;
+                    break;
+                }
+            }
+        }
+        
+        if (!endOfBody && c != '\n') {
+            if (c >= 0) line += (char)c;
+            continue;
+        }
+        
+        // A complete line (or the unterminated last one)
+        lines++;
+        line.trim();
+        int eq = line.indexOf('=');
+        if (eq > 0) {
+            String key = line.substring(0, eq);
+            String value = line.substring(eq + 1);
+            
+            if (key == "version") version = value;
+            else if (key == "sha256") sha = value;
+            else if (key == "delta") delta = value;
+            else if (key == "delta_size") dSize = value.toInt();
+        }
+        line = "";
+        if (endOfBody) break;
+    }
+    http.end();
+    
+    if (tooLarge) {
+        Serial.println("[OTA] Manifest body over " + String(MANIFEST_MAX_BYTES) + " bytes - rejected");
+        prefs.end();
+        return MANIFEST_FAILED;
+    }
+    if (version.length() == 0) {
+        Serial.println("[OTA] Manifest has no version");
+        prefs.end();
+        return MANIFEST_FAILED;
+    }
+    
+    prefs.end();
+    
+    storeManifest(newEtag, version, sha, delta, dSize);
+    applyManifest(version, sha, delta, dSize);
+    return MANIFEST_OK;
+}
+
+void OTAUpdater::storeManifest(const String& etag, const String& version, const String& sha,
+                               const String& delta, int dSize) {
+    Preferences prefs;
+    prefs.begin(OTA_CHECK_NAMESPACE, false);
+    prefs.putString("etag", etag);
+    prefs.putString("version", version);
+    prefs.putString("sha256", sha);
+    prefs.putString("delta", delta);
+    prefs.putInt("delta_size", dSize);
+    prefs.putUInt("checked", (uint32_t)time(nullptr));
+    prefs.end();
+}
+
+// Restore the last manifest from NVS. With onlyIfFresh, only succeeds inside the
+// minimum check interval (and only once the clock is set, so an unsynced boot checks)
+bool OTAUpdater::loadCachedManifest(bool onlyIfFresh) {
+    Preferences prefs;
+    prefs.begin(OTA_CHECK_NAMESPACE, true);
+    String version = prefs.getString("version", "");
+    uint32_t checked = prefs.getUInt("checked", 0);
+    String sha = prefs.getString("sha256", "");
+    String delta = prefs.getString("delta", "");
+    int dSize = prefs.getInt("delta_size", 0);
+    prefs.end();
+    
+    if (version.length() == 0) return false;
+    
+    if (onlyIfFresh) {
+        time_t now = time(nullptr);
+        if (now < OTA_CLOCK_VALID || checked == 0 || (uint32_t)now < checked ||
+            (uint32_t)now - checked >= minCheckInterval) {
+            return false;
+        }
+        Serial.println("[OTA] Checked " + String((uint32_t)now - checked) + "s ago - using cached manifest");
+    }
+    
+    applyManifest(version, sha, delta, dSize);
+    return true;
+}
+
+void OTAUpdater::applyManifest(const String& version, const String& sha, const String& delta, int dSize) {
+    String base = "https://github.com/" + githubOwner + "/" + githubRepo + "/releases/download/" + version + "/";
+    latestVersion = version;
+    downloadURL = base + "firmware-" + version + ".bin";
+    downloadHash = sha;
+    
+    // The delta only helps a device running exactly its base version
+    if (delta.length() > 0 && delta == currentVersion) {
+        deltaURL = base + "firmware-delta-" + delta + ".patch";
+        deltaSize = dSize;
+    } else {
+        deltaURL = "";
+        deltaSize = 0;
+    }
+}
+
+void OTAUpdater::setMinCheckInterval(uint32_t seconds) {
+    minCheckInterval = seconds;
+}
+
 bool OTAUpdater::compareVersions(const String& v1, const String& v2) {
     // Simple string comparison for now
     // Format: v0.13.0 vs v0.12.0
@@ -213,60 +447,138 @@ bool OTAUpdater::performUpdate() {
     Serial.println("[OTA] Free heap: " + String(ESP.getFreeHeap()) + " bytes");
     Serial.println("[OTA] ====================================");
     
+    // Try the delta first - a point release is a few percent of the full image.
+    // Any failure leaves the running app untouched, so fall through to the full download.
+    if (deltaURL.length() > 0) {
+        if (performDeltaUpdate()) {
+            if (logger) logger->info("OTA: Delta update successful, restarting...");
+            Serial.println("[OTA] Delta update successful! Restarting in 2 seconds...");
+            status = UPDATE_SUCCESS;
+            if (logger) logger->flush();
+            delay(2000);
+            ESP.restart();
+            return true;
+        }
+        if (logger) logger->error("OTA: Delta update failed, downloading full image");
+        Serial.println("[OTA] Delta update failed - falling back to full image");
+        status = UPDATE_DOWNLOADING;
+    }
+    
     if (logger) logger->info("OTA: Starting update from " + downloadURL);
     
-    // Set up progress callback
-    if (progressCallback) {
-        httpUpdate.onProgress([](int progress, int total) {
-            if (instance && instance->progressCallback) {
-                instance->progressCallback(progress, total);
-            }
-        });
+    // Resumable download straight into the inactive slot - a dropped connection
+    // continues from the last written chunk instead of byte zero (see OTADownloader.h)
+    Serial.println("[OTA] Starting update process...");
+    Serial.println("[OTA] This will take a few minutes...");
+    unsigned long startTime = millis();
+    
+    OTADownloader downloader;
+    if (!downloader.download(downloadURL, downloadHash, progressCallback)) {
+        if (logger) logger->error("OTA failed: " + downloader.getError());
+        Serial.println("[OTA] Update failed: " + downloader.getError());
+        status = UPDATE_FAILED;
+        return false;
     }
     
-    // Configure HTTPUpdate for better reliability
-    httpUpdate.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    httpUpdate.rebootOnUpdate(true);  // Let HTTPUpdate handle the reboot automatically
+    if (logger) logger->info("OTA: Update successful, restarting...");
+    Serial.println("[OTA] Update successful in " + String(millis() - startTime) + "ms! Restarting in 2 seconds...");
+    status = UPDATE_SUCCESS;
+    if (logger) logger->flush();
+    delay(2000);
+    ESP.restart();
+    return true;
+}
+
+bool OTAUpdater::performDeltaUpdate() {
+    Serial.println("[OTA] Starting delta update from " + deltaURL);
+    if (logger) logger->info("OTA: Starting delta update from " + deltaURL);
+    unsigned long startTime = millis();
+    
+    // The patch overwrites the inactive slot - a saved partial download is no longer there
+    OTADownloader::clearResumeState();
     
-    // Perform update with better timeout handling
     WiFiClientSecure client;
-    client.setInsecure();  // Skip certificate validation for GitHub
-    client.setTimeout(60000);  // 60 second timeout
+    client.setInsecure();  // Skip certificate validation for GitHub (patch is hash-verified)
+    client.setTimeout(60000);
     
-    // Set larger buffer for faster download
-    client.setNoDelay(true);
+    HTTPClient http;
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);  // Assets redirect to the CDN
+    http.begin(client, deltaURL);
+    http.addHeader("User-Agent", "SmolTxt-OTA");
     
-    Serial.println("[OTA] Starting update process...");
-    Serial.println("[OTA] This will take a few minutes...");
+    int httpCode = http.GET();
+    if (httpCode != HTTP_CODE_OK) {
+        if (logger) logger->error("OTA delta download failed, code=" + String(httpCode));
+        Serial.println("[OTA] Delta download failed, code: " + String(httpCode));
+        http.end();
+        return false;
+    }
     
-    t_httpUpdate_return ret = httpUpdate.update(client, downloadURL);
+    int total = http.getSize();
+    if (total <= 0) total = deltaSize;
+    WiFiClient* stream = http.getStreamPtr();
+    
+    DeltaPatcher patcher;
+    uint8_t buffer[1024];
+    int received = 0;
+    unsigned long lastData = millis();
+    
+    status = UPDATE_INSTALLING;  // Download and install happen together
+    // Keep reading after the server closes - the tail of the patch may still be buffered
+    while (total <= 0 || received < total) {
+        size_t available = stream->available();
+        if (available == 0) {
+            if (!http.connected()) break;  // Closed and drained
+            if (millis() - lastData > 15000) {
+                Serial.println("[OTA] Delta download stalled");
+                break;
+            }
+            delay(1);
+            continue;
+        }
+        
+        int n = stream->readBytes(buffer, min(available, sizeof(buffer)));
+        if (n <= 0) continue;
+        lastData = millis();
+        received += n;
+        
+        if (!patcher.write(buffer, n)) {
+            break;
+        }
+        if (progressCallback) {
+            progressCallback(received, total);
+        }
+    }
+    http.end();
     
-    switch (ret) {
-        case HTTP_UPDATE_FAILED:
-            if (logger) logger->error("OTA failed: " + String(httpUpdate.getLastErrorString()));
-            Serial.println("[OTA] Update failed: " + String(httpUpdate.getLastErrorString()));
-            Serial.println("[OTA] Error code: " + String(httpUpdate.getLastError()));
-            status = UPDATE_FAILED;
-            return false;
-            
-        case HTTP_UPDATE_NO_UPDATES:
-            if (logger) logger->info("OTA: No update needed");
-            Serial.println("[OTA] No update needed");
-            status = UPDATE_NO_UPDATE;
-            return false;
-            
-        case HTTP_UPDATE_OK:
-            // This code should never execute because rebootOnUpdate(true) will restart
-            // But if we get here somehow, manually restart
-            if (logger) logger->info("OTA: Update successful, restarting...");
-            Serial.println("[OTA] Update successful! Restarting in 2 seconds...");
-            status = UPDATE_SUCCESS;
-            delay(2000);
-            ESP.restart();
-            return true;
+    if (!patcher.finish()) {
+        if (logger) logger->error("OTA delta failed: " + patcher.getError());
+        return false;
     }
     
-    return false;
+    Serial.println("[OTA] Delta applied: " + String(received) + " byte patch -> " +
+                   String(patcher.getNewSize()) + " byte image in " + String(millis() - startTime) + "ms");
+    if (logger) logger->info("OTA: Delta applied (" + String(received) + " bytes downloaded)");
+    return true;
+}
+
+// Optional "<hex>  firmware.bin" file next to a custom image - empty if absent
+String OTAUpdater::fetchSidecarHash(const String& url) {
+    HTTPClient http;
+    http.begin(url);
+    http.addHeader("User-Agent", "SmolTxt-OTA");
+    
+    String hash = "";
+    if (http.GET() == HTTP_CODE_OK) {
+        String body = http.getString();
+        body.trim();
+        if (body.length() >= 64) {
+            hash = body.substring(0, 64);
+            Serial.println("[OTA] Expected SHA-256: " + hash);
+        }
+    }
+    http.end();
+    return hash;
 }
 
 UpdateStatus OTAUpdater::getStatus() {
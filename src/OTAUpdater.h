@@ -5,6 +5,7 @@
 #include <HTTPClient.h>
 #include <HTTPUpdate.h>
 #include <ArduinoJson.h>
+#include <Preferences.h>
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include "Logger.h"
@@ -13,6 +14,13 @@
 // Firmware version uses BUILD_NUMBER from version.h
 #define FIRMWARE_VERSION BUILD_NUMBER
 
+#define OTA_CHECK_NAMESPACE "ota_check"          // Cached manifest + ETag
+#define OTA_DEFAULT_CHECK_INTERVAL (6 * 3600)    // Seconds between unforced checks
+#define OTA_CLOCK_VALID 1700000000               // time() below this = NTP not synced yet
+#define MANIFEST_MAX_LINES 16
+#define MANIFEST_MAX_BYTES 1024                  // Real manifests are ~150 bytes
+#define MANIFEST_READ_TIMEOUT 5000               // No bytes for this long = give up on the body
+
 enum UpdateStatus {
     UPDATE_IDLE,
     UPDATE_CHECKING,
@@ -31,9 +39,11 @@ public:
     // Initialize updater
     bool begin(Logger* loggerInstance = nullptr);
     
-    // Check for updates (non-blocking)
-    // Returns true if new version available
-    bool checkForUpdate();
+    // Check for updates (blocking, but cheap - see fetchManifest)
+    // Returns true if new version available. Unforced checks inside the minimum
+    // interval are answered from the cached manifest without touching the network.
+    bool checkForUpdate(bool force = false);
+    void setMinCheckInterval(uint32_t seconds);
     
     // Download and install update (blocking)
     // Returns true if successful (will restart device)
@@ -45,6 +55,7 @@ public:
     String getCurrentVersion();
     String getLatestVersion();
     String getUpdateURL();
+    bool hasDeltaUpdate() { return deltaURL.length() > 0; }
     
     // Configure update source
     void setGitHubRepo(const String& owner, const String& repo);
@@ -59,17 +70,31 @@ private:
     String currentVersion;
     String latestVersion;
     String downloadURL;
+    String downloadHash;    // SHA-256 (hex) of firmware.bin when the source publishes one
+    String deltaURL;        // firmware-delta-<current>.patch from the release, if published
+    int deltaSize;
     String releaseNotes;
     String githubOwner;
     String githubRepo;
     String customURL;
+    uint32_t minCheckInterval;
     
     void (*progressCallback)(int progress, int total);
     
-    // GitHub API integration
+    // Release manifest (preferred) and GitHub API (fallback)
+    enum ManifestResult { MANIFEST_OK, MANIFEST_UNCHANGED, MANIFEST_FAILED };
+    int fetchManifest();
+    bool loadCachedManifest(bool onlyIfFresh);
+    void storeManifest(const String& etag, const String& version, const String& sha, const String& delta, int dSize);
+    void applyManifest(const String& version, const String& sha, const String& delta, int dSize);
     bool fetchLatestRelease();
+    bool reportLatest();
     bool compareVersions(const String& v1, const String& v2);
     
+    // Delta update - streams a patch against the running image (see DeltaPatcher.h)
+    bool performDeltaUpdate();
+    String fetchSidecarHash(const String& url);
+    
     // Update progress callback (static for HTTPUpdate)
     static void updateProgress(int progress, int total);
     static OTAUpdater* instance; // For static callback
@@ -0,0 +1,288 @@
+#include "Scheduler.h"
+#include <esp_sleep.h>
+#include <esp_pm.h>
+
+Scheduler scheduler;
+
+Scheduler::Scheduler() {
+    taskCount = 0;
+    wakeup = nullptr;
+    owner = nullptr;
+    wakePin = GPIO_NUM_NC;
+    wakeTask = -1;
+    lightSleepAllowed = nullptr;
+    autoLightSleep = false;
+    idleUs = 0;
+    idleWaits = 0;
+    lightSleepUs = 0;
+    lightSleeps = 0;
+    statsStartMs = 0;
+}
+
+void Scheduler::begin() {
+    if (!wakeup) {
+        wakeup = xSemaphoreCreateBinary();
+    }
+    owner = xTaskGetCurrentTaskHandle();
+    statsStartMs = millis();
+}
+
+void Scheduler::enableLightSleep(gpio_num_t pin, int task, bool (*allowed)()) {
+    wakePin = pin;
+    wakeTask = task;
+    lightSleepAllowed = allowed;
+
+#if CONFIG_PM_ENABLE
+    // Only succeeds on a custom core built with tickless idle - the stock arduino-esp32
+    // core isn't, so this normally fails and the explicit radio-off path is used
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t pm = {};
+#else
+    esp_pm_config_esp32s3_t pm = {};
+#endif
+    pm.max_freq_mhz = getCpuFrequencyMhz();
+    pm.min_freq_mhz = 80;  // Lowest that keeps Wi-Fi working
+    pm.light_sleep_enable = true;
+    autoLightSleep = (esp_pm_configure(&pm) == ESP_OK);
+#endif
+
+    if (autoLightSleep) {
+        // Wake source stays armed - esp_pm decides when to sleep
+        gpio_wakeup_enable(wakePin, GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+    }
+    Serial.println("[Scheduler] Light sleep: " + String(autoLightSleep ? "automatic (esp_pm)" : "explicit, only while Wi-Fi is down"));
+}
+
+int Scheduler::addTask(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t deadlineMs,
+                       TaskPriority priority, bool nestable) {
+    if (taskCount >= MAX_SCHEDULER_TASKS) {
+        Serial.println("[Scheduler] Task table full - cannot add " + String(name));
+        return -1;
+    }
+
+    Task& task = tasks[taskCount];
+    memset(&task, 0, sizeof(Task));
+    task.name = name;
+    task.callback = callback;
+    task.periodMs = periodMs;
+    task.deadlineMs = deadlineMs;
+    task.priority = priority;
+    task.nestable = nestable;
+    task.nextRun = millis();  // Periodic tasks run on the first pass
+    return taskCount++;
+}
+
+void Scheduler::setPeriod(int id, uint32_t periodMs) {
+    if (id < 0 || id >= taskCount) return;
+    tasks[id].periodMs = periodMs;
+    tasks[id].nextRun = millis() + periodMs;
+}
+
+void Scheduler::signal(int id) {
+    if (id < 0 || id >= taskCount) return;
+    if (!tasks[id].signaled) {
+        tasks[id].signaledAt = millis();
+        tasks[id].signaled = true;
+    }
+    if (wakeup) xSemaphoreGive(wakeup);
+}
+
+void Scheduler::signalFromISR(int id) {
+    if (id < 0 || id >= taskCount) return;
+    if (!tasks[id].signaled) {
+        tasks[id].signaledAt = millis();
+        tasks[id].signaled = true;
+    }
+    if (wakeup) {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(wakeup, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+}
+
+bool Scheduler::isDue(const Task& task, uint32_t now) const {
+    if (task.running) return false;  // Never re-entered from a nested delay()
+    if (task.signaled) return true;
+    return task.periodMs > 0 && (int32_t)(now - task.nextRun) >= 0;
+}
+
+bool Scheduler::runNextDue(bool nestedOnly, uint32_t& ranMask) {
+    uint32_t now = millis();
+    int best = -1;
+    for (int i = 0; i < taskCount; i++) {
+        if (ranMask & (1UL << i)) continue;  // Once per pass - a busy task can't starve the rest
+        if (nestedOnly && !tasks[i].nestable) continue;
+        if (!isDue(tasks[i], now)) continue;
+        if (best < 0 || tasks[i].priority > tasks[best].priority) {
+            best = i;
+        }
+    }
+    if (best < 0) return false;
+
+    ranMask |= 1UL << best;
+    runTask(best, now);
+    return true;
+}
+
+void Scheduler::runTask(int id, uint32_t now) {
+    Task& task = tasks[id];
+
+    bool wasSignaled = task.signaled;
+    uint32_t dueAt = wasSignaled ? task.signaledAt : task.nextRun;
+    task.signaled = false;
+
+    if (task.periodMs > 0) {
+        if (wasSignaled) {
+            task.nextRun = now + task.periodMs;
+        } else {
+            task.nextRun += task.periodMs;
+            if ((int32_t)(now - task.nextRun) >= 0) {
+                task.nextRun = now + task.periodMs;  // Overran - skip the missed slots rather than burst
+            }
+        }
+    }
+
+    uint32_t lateMs = now - dueAt;
+    if (lateMs > task.maxLateMs) task.maxLateMs = lateMs;
+    if (lateMs > task.deadlineMs) task.misses++;
+
+    task.running = true;
+    uint32_t startUs = micros();
+    task.callback();
+    uint32_t runUs = micros() - startUs;
+    task.running = false;
+
+    task.runs++;
+    task.totalRunUs += runUs;
+    if (runUs > task.maxRunUs) task.maxRunUs = runUs;
+}
+
+uint32_t Scheduler::msUntilNextDue(bool nestedOnly) const {
+    uint32_t now = millis();
+    uint32_t wait = UINT32_MAX;
+    for (int i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        if (task.running || (nestedOnly && !task.nestable)) continue;
+        if (task.signaled) return 0;
+        if (task.periodMs == 0) continue;
+
+        int32_t remaining = (int32_t)(task.nextRun - now);
+        if (remaining <= 0) return 0;
+        if ((uint32_t)remaining < wait) wait = remaining;
+    }
+    return wait;
+}
+
+void Scheduler::idle(uint32_t ms) {
+    // A held key keeps the wake pin low - sleeping would return immediately
+    if (wakePin != GPIO_NUM_NC && !autoLightSleep && ms >= LIGHT_SLEEP_MIN_MS &&
+        gpio_get_level(wakePin) == 1 && lightSleepAllowed && lightSleepAllowed()) {
+        lightSleep(ms);
+        return;
+    }
+
+    uint32_t startUs = micros();
+    if (wakeup) {
+        // Blocks the loop task - a signal() ends the wait early
+        xSemaphoreTake(wakeup, pdMS_TO_TICKS(ms));
+    } else {
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+    idleUs += micros() - startUs;
+    idleWaits++;
+}
+
+void Scheduler::lightSleep(uint32_t ms) {
+    Serial.flush();  // UART output is lost mid-sleep
+
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+    gpio_wakeup_enable(wakePin, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
+    uint64_t startUs = esp_timer_get_time();
+    esp_light_sleep_start();
+    uint64_t sleptUs = esp_timer_get_time() - startUs;
+
+    // Disarm again - deep sleep configures its own sources, and the pin is shared
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    gpio_wakeup_disable(wakePin);
+
+    idleUs += sleptUs;
+    idleWaits++;
+    lightSleepUs += sleptUs;
+    lightSleeps++;
+
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO) {
+        signal(wakeTask);
+    }
+}
+
+void Scheduler::run() {
+    uint32_t ranMask = 0;
+    while (runNextDue(false, ranMask)) {
+    }
+
+    uint32_t wait = msUntilNextDue(false);
+    if (wait > 0) {
+        idle(wait == UINT32_MAX ? 1000 : wait);
+    }
+}
+
+void Scheduler::delay(uint32_t ms) {
+    if (xTaskGetCurrentTaskHandle() != owner) {
+        // Called from another FreeRTOS task (e.g. an MQTT callback) - the task table
+        // belongs to the loop task, so just block
+        vTaskDelay(pdMS_TO_TICKS(ms));
+        return;
+    }
+
+    uint32_t start = millis();
+    while (millis() - start < ms) {
+        uint32_t ranMask = 0;
+        while (runNextDue(true, ranMask)) {
+        }
+
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= ms) break;
+        uint32_t wait = min(ms - elapsed, msUntilNextDue(true));
+        if (wait > 0) idle(wait);
+    }
+}
+
+void Scheduler::printStats(Print& out) {
+    uint32_t windowMs = millis() - statsStartMs;
+
+    out.println("=== TASKS ===");
+    out.printf("window: %lus  idle: %.1f%% (%u waits)\n", windowMs / 1000,
+               windowMs > 0 ? idleUs / 10.0f / windowMs : 0.0f, (unsigned)idleWaits);
+    if (autoLightSleep) {
+        out.println("light sleep: automatic (esp_pm) during idle");
+    } else if (wakePin != GPIO_NUM_NC) {
+        out.printf("light sleep: %.1f%% (%u sleeps)\n",
+                   windowMs > 0 ? lightSleepUs / 10.0f / windowMs : 0.0f, (unsigned)lightSleeps);
+    }
+    out.printf("%-10s %7s %8s %6s %8s %8s %8s\n", "task", "period", "runs", "miss", "maxLate", "avgUs", "maxUs");
+    for (int i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        out.printf("%-10s %7u %8u %6u %8u %8u %8u\n", task.name, (unsigned)task.periodMs,
+                   (unsigned)task.runs, (unsigned)task.misses, (unsigned)task.maxLateMs,
+                   (unsigned)(task.runs > 0 ? task.totalRunUs / task.runs : 0), (unsigned)task.maxRunUs);
+    }
+}
+
+void Scheduler::resetStats() {
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].runs = 0;
+        tasks[i].misses = 0;
+        tasks[i].maxLateMs = 0;
+        tasks[i].maxRunUs = 0;
+        tasks[i].totalRunUs = 0;
+    }
+    idleUs = 0;
+    idleWaits = 0;
+    lightSleepUs = 0;
+    lightSleeps = 0;
+    statsStartMs = millis();
+}
@@ -0,0 +1,114 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <driver/gpio.h>
+
+#define MAX_SCHEDULER_TASKS 12
+#define LIGHT_SLEEP_MIN_MS 20      // Shorter idle waits aren't worth a light-sleep round trip
+
+typedef void (*TaskCallback)();
+
+enum TaskPriority {
+    PRIORITY_LOW = 0,
+    PRIORITY_NORMAL,
+    PRIORITY_HIGH
+};
+
+// Cooperative run-to-completion scheduler for the main loop task.
+// Each task has a period (0 = event-driven only), a deadline - how late it may start
+// before that run counts as a miss - and a priority that orders tasks due together.
+// signal() makes a task due immediately and wakes the idle wait, so event-driven work
+// (a key press, an incoming message) doesn't wait for the next poll.
+//
+// Between runs the loop task blocks until the next deadline instead of spinning, so
+// the FreeRTOS idle task gets the CPU.
+//
+// Light sleep (enableLightSleep): idle waits of LIGHT_SLEEP_MIN_MS or more become an
+// explicit esp_light_sleep_start() whenever the app's allowed() check passes. That
+// drops the radio, so the app only allows it with Wi-Fi down - while connected the
+// chip stays awake and only Wi-Fi modem sleep saves power. The wake pin going low
+// (a key press) ends the sleep and signals the wake task.
+// Light sleep that keeps Wi-Fi associated needs esp_pm with CONFIG_PM_ENABLE and
+// CONFIG_FREERTOS_USE_TICKLESS_IDLE, which the stock arduino-esp32 core is not built
+// with. On a core that is, esp_pm_configure() succeeds and takes over instead.
+//
+// delay() replaces busy-wait pauses inside handlers: it keeps running the tasks marked
+// nestable (keyboard, MQTT) but never re-enters a task that is already running.
+// Per-task stats are printed by the !TASKS serial command (see Logger::update).
+class Scheduler {
+private:
+    struct Task {
+        const char* name;
+        TaskCallback callback;
+        uint32_t periodMs;
+        uint32_t deadlineMs;
+        TaskPriority priority;
+        bool nestable;             // May run from delay() inside another task
+        bool running;
+        volatile bool signaled;
+        volatile uint32_t signaledAt;
+        uint32_t nextRun;          // millis() when next due (periodic tasks)
+
+        uint32_t runs;
+        uint32_t misses;           // Started later than deadlineMs after becoming due
+        uint32_t maxLateMs;
+        uint32_t maxRunUs;
+        uint64_t totalRunUs;
+    };
+
+    Task tasks[MAX_SCHEDULER_TASKS];
+    int taskCount;
+    SemaphoreHandle_t wakeup;      // Given by signal() to cut the idle wait short
+    TaskHandle_t owner;            // Task that runs loop() - delay() elsewhere just blocks
+
+    gpio_num_t wakePin;            // GPIO_NUM_NC = light sleep disabled
+    int wakeTask;
+    bool (*lightSleepAllowed)();
+    bool autoLightSleep;           // esp_pm handles it - no explicit sleeps
+
+    uint64_t idleUs;
+    uint32_t idleWaits;
+    uint64_t lightSleepUs;         // Explicit light sleeps only
+    uint32_t lightSleeps;
+    uint32_t statsStartMs;
+
+    bool isDue(const Task& task, uint32_t now) const;
+    bool runNextDue(bool nestedOnly, uint32_t& ranMask);
+    void runTask(int id, uint32_t now);
+    uint32_t msUntilNextDue(bool nestedOnly) const;
+    void idle(uint32_t ms);
+    void lightSleep(uint32_t ms);
+
+public:
+    Scheduler();
+
+    void begin();
+    // Returns the task id, or -1 when the table is full
+    int addTask(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t deadlineMs,
+                TaskPriority priority, bool nestable = false);
+    void setPeriod(int id, uint32_t periodMs);  // 0 = only run when signaled
+
+    // Sleep through idle waits; a low level on wakePin wakes up and signals wakeTask.
+    // allowed() is checked before every explicit sleep (not used with esp_pm)
+    void enableLightSleep(gpio_num_t wakePin, int wakeTask, bool (*allowed)());
+    bool isAutoLightSleep() const { return autoLightSleep; }
+
+    void signal(int id);           // Run the task as soon as possible
+    void signalFromISR(int id);
+
+    void run();                    // One pass over the due tasks, then idle until the next - call from loop()
+    void delay(uint32_t ms);       // Cooperative pause for use inside a task
+
+    uint64_t getIdleUs() const { return idleUs; }
+    uint64_t getLightSleepUs() const { return lightSleepUs; }
+    uint32_t getStatsWindowMs() const { return millis() - statsStartMs; }
+    void printStats(Print& out);
+    void resetStats();
+};
+
+extern Scheduler scheduler;
+
+#endif
@@ -1,12 +1,6 @@
 #include "UI.h"
-
-// Forward declaration for conversation list structure from main.cpp
-struct ConversationEntry {
-    int slot;
-    String name;
-    String id;
-    unsigned long lastActivity;
-};
+#include "ConversationIndex.h"  // ConversationEntry (list itself lives in main.cpp)
+#include "Metrics.h"
 
 UI::UI() {
     displaySPI = nullptr;
@@ -16,13 +10,21 @@ UI::UI() {
     inputText = "";
     inputComplete = false;
     messageScrollOffset = 0;
+    newerOutsideWindow = 0;
+    olderExhausted = false;
+    historyPageLoader = nullptr;
+    postedLock = xSemaphoreCreateMutex();
+    postedDropped = 0;
     typingCheckCallback = nullptr;
+    bandLineY = 0;
+    hasBandLine = false;
     batteryVoltage = 0.0;
     batteryPercent = 0;
     ringtoneEnabled = true;  // Default to on
     ringtoneName = "Rising Tone";  // Default ringtone name
     savedNetworkCount = 0;  // No saved networks initially
     isWiFiConnected = false;
+    isNetworkScanning = false;
 }
 
 bool UI::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t cs, int8_t dc, int8_t rst, int8_t busy) {
@@ -50,9 +52,12 @@ void UI::update() {
     // Note: Don't defer the first update after state changes, always let it draw
     // Only defer subsequent updates during active typing to keep keyboard responsive
     if (typingCheckCallback && typingCheckCallback() && currentState == STATE_MESSAGING) {
+        framePending = true;  // Redraw once typing pauses (picked up by serviceFrame)
         return;  // Skip display refresh during typing in messaging screen only
     }
     
+    beginFrame();
+    
     // Use partial refresh for fast, no-flash updates
     display->setPartialWindow(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
     display->fillScreen(GxEPD_WHITE);
@@ -141,11 +146,13 @@ void UI::update() {
             break;
     }
     
-    display->display(true);  // Partial refresh - no flash
+    refreshDisplay(true);  // Partial refresh - no flash
+    markFrameDrawn();
 }
 
 void UI::updatePartial() {
     // Fast partial refresh - single draw, no loop
+    beginFrame();
     display->setPartialWindow(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
     display->fillScreen(GxEPD_WHITE);
     
@@ -230,15 +237,17 @@ void UI::updatePartial() {
             break;
     }
     
-    display->display(true);  // Partial refresh
+    refreshDisplay(true);  // Partial refresh
+    markFrameDrawn();
 }
 
 void UI::updateClean() {
     // Clean transition: clear to white with partial, then draw content with partial
     // This minimizes ghosting better than single partial refresh
+    beginFrame();
     display->setPartialWindow(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
     display->fillScreen(GxEPD_WHITE);
-    display->display(true);  // Partial refresh to clear
+    refreshDisplay(true);  // Partial refresh to clear
     
     // Now draw the actual content
     display->fillScreen(GxEPD_WHITE);
@@ -277,11 +286,13 @@ void UI::updateClean() {
         case STATE_SLEEPING:        drawSleeping(); break;
         case STATE_CONVERSATION_MENU:    drawConversationMenu(); break;
     }
-    display->display(true);  // Partial refresh to draw content
+    refreshDisplay(true);  // Partial refresh to draw content
+    markFrameDrawn();
 }
 
 void UI::updateFull() {
     // Full refresh: set full window, draw current state, then use full waveform
+    beginFrame();
     display->setFullWindow();
     display->fillScreen(GxEPD_WHITE);
     switch (currentState) {
@@ -318,7 +329,67 @@ void UI::updateFull() {
         case STATE_POWERING_DOWN:   drawPoweringDown(); break;
         case STATE_SLEEPING:        drawSleeping(); break;
     }
-    display->display(false);  // Full refresh (multi-phase, clears ghosting)
+    refreshDisplay(false);  // Full refresh (multi-phase, clears ghosting)
+    markFrameDrawn();
+}
+
+void UI::requestUpdate() {
+    // Safe to call from the MQTT task - only sets a flag, drawing happens in loop()
+    framePending = true;
+}
+
+void UI::setStatusText(const String& text) {
+    if (text == statusText) return;
+    statusText = text;
+    requestUpdate();
+}
+
+void UI::serviceFrame() {
+    if (!framePending) return;
+    
+    // Coalesce bursts (e.g. sync batches) - at most one redraw per frame interval
+    if (millis() - lastFrameMs < FRAME_INTERVAL_MS) return;
+    
+    update();  // Leaves framePending set if deferred by typing
+}
+
+void UI::refreshDisplay(bool partial) {
+    MetricTimer timer(HIST_DISPLAY_REFRESH);
+    display->display(partial);
+    metrics.increment(partial ? CTR_DISPLAY_PARTIAL : CTR_DISPLAY_FULL);
+    metrics.markScreenUpdated();
+}
+
+void UI::updateInputLine() {
+    if (currentState != STATE_MESSAGING) {
+        updatePartial();
+        return;
+    }
+    
+    MetricTimer timer(HIST_INPUT_LINE);
+    display->setPartialWindow(0, INPUT_BAND_TOP, SCREEN_WIDTH, SCREEN_HEIGHT - INPUT_BAND_TOP);
+    display->fillScreen(GxEPD_WHITE);
+    
+    // Drawing is clipped to the band - restore the part of the last message line in it
+    if (hasBandLine) {
+        display->setFont(&FreeSans9pt7b);
+        drawMessageLine(bandLine, 5, bandLineY);
+    }
+    drawMessagingInputLine();
+    
+    refreshDisplay(true);
+    // Not a frame: a pending full redraw (e.g. a message that arrived) still goes out
+}
+
+void UI::beginFrame() {
+    // Consume the request before drawing - one made during the ~300ms panel refresh
+    // (e.g. a message from the MQTT task) stays pending for the next frame
+    framePending = false;
+    prepareMessagingDraw();
+}
+
+void UI::markFrameDrawn() {
+    lastFrameMs = millis();
 }
 
 void UI::setTypingCheckCallback(bool (*callback)()) {
@@ -405,6 +476,16 @@ void UI::drawConversationList() {
         }
         display->setCursor(10, y);
         display->print(conversationList[i].name);
+        
+        // Unread badge, right-aligned
+        if (conversationList[i].unreadCount > 0) {
+            String badge = "(" + String(conversationList[i].unreadCount) + ")";
+            int16_t x1, y1;
+            uint16_t w, h;
+            display->getTextBounds(badge, 0, 0, &x1, &y1, &w, &h);
+            display->setCursor(SCREEN_WIDTH - 12 - w, y);
+            display->print(badge);
+        }
         if (menuSelection == i) {
             display->setTextColor(GxEPD_BLACK);
         }
@@ -578,7 +659,7 @@ void UI::drawWiFiNetworkList() {
     
     if (totalItems == 0) {
         display->setCursor(10, 60);
-        display->print("No networks found");
+        display->print(isNetworkScanning ? "Scanning..." : "No networks found");
         display->setCursor(10, 85);
         display->print("Press LEFT to go back");
         return;
@@ -1004,6 +1085,189 @@ void UI::drawViewMembers() {
     }
 }
 
+// Word-wrap one message into display lines (first line carries the bold sender)
+void UI::layoutMessage(const HistoryEntry& msg, int maxLineWidth, std::vector<DisplayLine>& messageLines) {
+    String msgSender = messageHistory.senderOf(msg);
+    
+    // Build the message text WITHOUT status
+    String msgText = "";
+    if (msgSender == currentUsername) {
+        msgText = "You: ";
+    } else {
+        String sender = msgSender;
+        if (sender.length() > 8) {
+            sender = sender.substring(0, 8);
+        }
+        msgText = sender + ": ";
+    }
+    
+    msgText += msg.content;
+    
+    // Determine status text (if any)
+    String statusText = "";
+    if (!msg.received) {
+        switch ((MessageStatus)msg.status) {
+            case MSG_SENT:
+                statusText = " (sent)";
+                break;
+            case MSG_RECEIVED:
+                statusText = " (rec'd)";
+                break;
+            case MSG_SEEN:
+                statusText = " (rec'd)";
+                break;
+            case MSG_READ:
+                statusText = " (read)";
+                break;
+        }
+    }
+    
+    // Word wrap the message text (without status) using pixel width
+    String remainingText = msgText;
+    bool firstLineOfMessage = true;
+    
+    // Extract sender part for bold rendering (without trailing space)
+    String senderPart = "";
+    if (msgSender == currentUsername) {
+        senderPart = "You:";
+    } else {
+        String sender = msgSender;
+        if (sender.length() > 8) {
+            sender = sender.substring(0, 8);
+        }
+        senderPart = sender + ":";
+    }
+    
+    while (remainingText.length() > 0) {
+        DisplayLine dLine;
+        dLine.isFirstLine = firstLineOfMessage;
+        dLine.senderPart = firstLineOfMessage ? senderPart : "";
+        
+        int availableWidth = maxLineWidth;
+        
+        // For first line, account for bold sender width + space
+        if (firstLineOfMessage && senderPart.length() > 0) {
+            int16_t x1, y1;
+            uint16_t w, h;
+            display->setFont(&FreeSansBold9pt7b);
+            display->getTextBounds(senderPart, 0, 0, &x1, &y1, &w, &h);
+            int senderWidth = w;
+            
+            // Add space width
+            display->setFont(&FreeSans9pt7b);
+            display->getTextBounds(" ", 0, 0, &x1, &y1, &w, &h);
+            int spaceWidth = w;
+            
+            availableWidth = maxLineWidth - senderWidth - spaceWidth;
+            
+            // For first line, remainingText is "You: message"
+            // We need to extract just "message" part for measurement
+            int colonPos = remainingText.indexOf(':');
+            if (colonPos >= 0 && colonPos + 2 < remainingText.length()) {
+                remainingText = remainingText.substring(colonPos + 2);  // Skip ": "
+            }
+        }
+        
+        firstLineOfMessage = false;
+        
+        // Measure how much text fits in availableWidth
+        int16_t x1, y1;
+        uint16_t w, h;
+        display->setFont(&FreeSans9pt7b);
+        display->getTextBounds(remainingText, 0, 0, &x1, &y1, &w, &h);
+        
+        if (w <= availableWidth) {
+            // Entire remaining text fits on one line
+            dLine.text = remainingText;
+            dLine.status = statusText;  // Status on last line
+            remainingText = "";
+        } else {
+            // Need to wrap - find longest substring that fits
+            int breakPoint = -1;
+            int lastSpacePos = -1;
+            
+            // Binary search for the longest fitting substring
+            int left = 1;
+            int right = remainingText.length();
+            int bestFit = 1;
+            
+            while (left <= right) {
+                int mid = (left + right) / 2;
+                String testStr = remainingText.substring(0, mid);
+                display->getTextBounds(testStr, 0, 0, &x1, &y1, &w, &h);
+                
+                if (w <= availableWidth) {
+                    bestFit = mid;
+                    left = mid + 1;
+                } else {
+                    right = mid - 1;
+                }
+            }
+            
+            // Now find last space before bestFit position
+            for (int j = bestFit; j > 0; j--) {
+                if (remainingText.charAt(j) == ' ') {
+                    lastSpacePos = j;
+                    break;
+                }
+            }
+            
+            // If we found a space, break there; otherwise force break at bestFit
+            if (lastSpacePos > 0 && lastSpacePos > bestFit / 2) {
+                breakPoint = lastSpacePos;
+            } else {
+                breakPoint = bestFit;
+            }
+            
+            dLine.text = remainingText.substring(0, breakPoint);
+            dLine.status = "";  // No status on wrapped lines
+            
+            // Move past the break point and trim leading space
+            remainingText = remainingText.substring(breakPoint);
+            if (remainingText.startsWith(" ")) {
+                remainingText = remainingText.substring(1);
+            }
+        }
+        
+        messageLines.push_back(dLine);
+    }
+}
+
+void UI::drawMessageLine(const DisplayLine& line, int leftMargin, int currentY) {
+    int xPos = leftMargin;
+    
+    // If first line, render sender name in bold
+    if (line.isFirstLine && line.senderPart.length() > 0) {
+        display->setFont(&FreeSansBold9pt7b);
+        display->setCursor(xPos, currentY);
+        display->print(line.senderPart);
+        
+        // Calculate width of sender part to position message text
+        int16_t x1, y1;
+        uint16_t w, h;
+        display->getTextBounds(line.senderPart, 0, 0, &x1, &y1, &w, &h);
+        xPos += w;
+        
+        // Render space and message in regular font
+        // Note: line.text now contains ONLY the message content (no sender prefix)
+        display->setFont(&FreeSans9pt7b);
+        display->setCursor(xPos, currentY);
+        display->print(" ");  // Space after colon
+        display->print(line.text);
+    } else {
+        // Continuation line - just regular font
+        display->setFont(&FreeSans9pt7b);
+        display->setCursor(xPos, currentY);
+        display->print(line.text);
+    }
+    
+    // Add status in small font if present
+    if (line.status.length() > 0) {
+        display->setFont();  // Small default font
+        display->print(line.status);
+    }
+}
+
 void UI::drawMessaging() {
     Serial.println("[UI] Drawing messaging. History size: " + String(messageHistory.size()));
     
@@ -1025,255 +1289,44 @@ void UI::drawMessaging() {
     int bottomY = cursorY - lineHeight;  // One full line above cursor
     
     if (messageHistory.size() == 0) {
+        hasBandLine = false;
         display->setCursor(10, 60);
         display->print("No messages yet");
     } else {
-        int msgCount = (int)messageHistory.size();
-        
-        // Build wrapped lines for ALL messages, newest to oldest
-        // Each message becomes multiple display lines
-        // messageScrollOffset tells us how many display LINES to scroll up
-        
-        // First pass: calculate all wrapped lines for all messages
-        // Store lines with status info so we can render status in small font
-        struct DisplayLine {
-            String text;
-            String status;  // Empty or "(sent)", "(read)", etc.
-            bool isFirstLine;  // First line of message (sender name bold)
-            String senderPart;  // "You: " or "Name: " for bold rendering
-        };
-        std::vector<DisplayLine> allLines;
+        // Virtualized view: only messages that land on screen are laid out. Walk back
+        // from the anchor (messageScrollOffset messages above the newest) until full.
+        std::vector<DisplayLine> messageLines;
+        int index = messageHistory.size() - 1 - messageScrollOffset;
+        int currentY = bottomY;
+        hasBandLine = false;
         
-        for (int i = msgCount - 1; i >= 0; i--) {  // Start from most recent
-            const Message& msg = messageHistory[i];
+        while (currentY >= topY - lineHeight) {  // Allow partial at top
+            if (index < 0) break;  // Ran out of loaded history (prepareMessagingDraw paged in what fits)
             
-            // Build the message text WITHOUT status
-            String msgText = "";
-            if (msg.sender == currentUsername) {
-                msgText = "You: ";
-            } else {
-                String sender = msg.sender;
-                if (sender.length() > 8) {
-                    sender = sender.substring(0, 8);
-                }
-                msgText = sender + ": ";
-            }
+            messageLines.clear();
+            layoutMessage(messageHistory.at(index), maxLineWidth, messageLines);
             
-            msgText += msg.content;
-            
-            // Determine status text (if any)
-            String statusText = "";
-            if (!msg.received) {
-                switch (msg.status) {
-                    case MSG_SENT:
-                        statusText = " (sent)";
-                        break;
-                    case MSG_RECEIVED:
-                        statusText = " (rec'd)";
-                        break;
-                    case MSG_SEEN:
-                        statusText = " (rec'd)";
-                        break;
-                    case MSG_READ:
-                        statusText = " (read)";
-                        break;
-                }
-            }
-            
-            // Word wrap the message text (without status) using pixel width
-            // Collect all lines for THIS message first
-            std::vector<DisplayLine> messageLines;
-            String remainingText = msgText;
-            bool firstLineOfMessage = true;
-            
-            // Extract sender part for bold rendering (without trailing space)
-            String senderPart = "";
-            if (msg.sender == currentUsername) {
-                senderPart = "You:";
-            } else {
-                String sender = msg.sender;
-                if (sender.length() > 8) {
-                    sender = sender.substring(0, 8);
+            // Draw bottom-up: last continuation line first, first line (with sender) on top
+            for (int j = messageLines.size() - 1; j >= 0 && currentY >= topY - lineHeight; j--) {
+                if (currentY == bottomY) {
+                    bandLine = messageLines[j];
+                    bandLineY = currentY;
+                    hasBandLine = true;
                 }
-                senderPart = sender + ":";
-            }
-            
-            while (remainingText.length() > 0) {
-                DisplayLine dLine;
-                dLine.isFirstLine = firstLineOfMessage;
-                dLine.senderPart = firstLineOfMessage ? senderPart : "";
-                
-                int availableWidth = maxLineWidth;
-                
-                // For first line, account for bold sender width + space
-                if (firstLineOfMessage && senderPart.length() > 0) {
-                    int16_t x1, y1;
-                    uint16_t w, h;
-                    display->setFont(&FreeSansBold9pt7b);
-                    display->getTextBounds(senderPart, 0, 0, &x1, &y1, &w, &h);
-                    int senderWidth = w;
-                    
-                    // Add space width
-                    display->setFont(&FreeSans9pt7b);
-                    display->getTextBounds(" ", 0, 0, &x1, &y1, &w, &h);
-                    int spaceWidth = w;
-                    
-                    availableWidth = maxLineWidth - senderWidth - spaceWidth;
-                    
-                    // For first line, remainingText is "You: message"
-                    // We need to extract just "message" part for measurement
-                    int colonPos = remainingText.indexOf(':');
-                    if (colonPos >= 0 && colonPos + 2 < remainingText.length()) {
-                        remainingText = remainingText.substring(colonPos + 2);  // Skip ": "
-                    }
-                }
-                
-                firstLineOfMessage = false;
-                
-                // Measure how much text fits in availableWidth
-                int16_t x1, y1;
-                uint16_t w, h;
-                display->setFont(&FreeSans9pt7b);
-                display->getTextBounds(remainingText, 0, 0, &x1, &y1, &w, &h);
-                
-                if (w <= availableWidth) {
-                    // Entire remaining text fits on one line
-                    dLine.text = remainingText;
-                    dLine.status = statusText;  // Status on last line
-                    remainingText = "";
-                } else {
-                    // Need to wrap - find longest substring that fits
-                    int breakPoint = -1;
-                    int lastSpacePos = -1;
-                    
-                    // Binary search for the longest fitting substring
-                    int left = 1;
-                    int right = remainingText.length();
-                    int bestFit = 1;
-                    
-                    while (left <= right) {
-                        int mid = (left + right) / 2;
-                        String testStr = remainingText.substring(0, mid);
-                        display->getTextBounds(testStr, 0, 0, &x1, &y1, &w, &h);
-                        
-                        if (w <= availableWidth) {
-                            bestFit = mid;
-                            left = mid + 1;
-                        } else {
-                            right = mid - 1;
-                        }
-                    }
-                    
-                    // Now find last space before bestFit position
-                    for (int j = bestFit; j > 0; j--) {
-                        if (remainingText.charAt(j) == ' ') {
-                            lastSpacePos = j;
-                            break;
-                        }
-                    }
-                    
-                    // If we found a space, break there; otherwise force break at bestFit
-                    if (lastSpacePos > 0 && lastSpacePos > bestFit / 2) {
-                        breakPoint = lastSpacePos;
-                    } else {
-                        breakPoint = bestFit;
-                    }
-                    
-                    dLine.text = remainingText.substring(0, breakPoint);
-                    dLine.status = "";  // No status on wrapped lines
-                    
-                    // Move past the break point and trim leading space
-                    remainingText = remainingText.substring(breakPoint);
-                    if (remainingText.startsWith(" ")) {
-                        remainingText = remainingText.substring(1);
-                    }
-                }
-                
-                messageLines.push_back(dLine);
-            }
-            
-            // Add this message's lines to allLines in REVERSE order
-            // (last continuation line first, then first line last)
-            // This way when drawn from bottom up, first line appears at bottom
-            for (int j = messageLines.size() - 1; j >= 0; j--) {
-                allLines.push_back(messageLines[j]);
-            }
-        }
-        
-        // Now draw lines with scroll offset applied
-        // allLines[0] = most recent message's first line
-        // messageScrollOffset = number of MESSAGE POSTS to skip (not lines)
-        // When scrollOffset > 0, we skip recent messages and show older ones
-        
-        int totalLines = allLines.size();
-        
-        // Calculate how many complete messages to skip
-        // We need to count messages, not lines
-        // Recount messages and their line counts
-        int linesSoFar = 0;
-        int linesToSkip = 0;
-        
-        // Count lines to skip based on messageScrollOffset (whole messages)
-        // We already calculated all lines in allLines, just count them by message
-        if (messageScrollOffset > 0) {
-            int msgsSkipped = 0;
-            int lineIdx = 0;
-            
-            // Walk through allLines counting complete messages
-            while (lineIdx < totalLines && msgsSkipped < messageScrollOffset) {
-                // Skip all lines of this message
-                while (lineIdx < totalLines) {
-                    linesToSkip++;
-                    lineIdx++;
-                    // If we hit a first line (next message), stop
-                    if (lineIdx < totalLines && allLines[lineIdx].isFirstLine) {
-                        break;
-                    }
-                }
-                msgsSkipped++;
+                drawMessageLine(messageLines[j], leftMargin, currentY);
+                currentY -= lineHeight;  // Next line goes up
             }
-        }
-        
-        // Draw from bottom to top, starting after skipped lines
-        int currentY = bottomY;
-        for (int i = linesToSkip; i < totalLines && currentY >= topY - lineHeight; i++) {  // Allow partial at top
-            int xPos = leftMargin;
-            
-            // If first line, render sender name in bold
-            if (allLines[i].isFirstLine && allLines[i].senderPart.length() > 0) {
-                display->setFont(&FreeSansBold9pt7b);
-                display->setCursor(xPos, currentY);
-                display->print(allLines[i].senderPart);
-                
-                // Calculate width of sender part to position message text
-                int16_t x1, y1;
-                uint16_t w, h;
-                display->getTextBounds(allLines[i].senderPart, 0, 0, &x1, &y1, &w, &h);
-                xPos += w;
-                
-                // Render space and message in regular font
-                // Note: allLines[i].text now contains ONLY the message content (no sender prefix)
-                display->setFont(&FreeSans9pt7b);
-                display->setCursor(xPos, currentY);
-                display->print(" ");  // Space after colon
-                display->print(allLines[i].text);
-            } else {
-                // Continuation line - just regular font
-                display->setFont(&FreeSans9pt7b);
-                display->setCursor(xPos, currentY);
-                display->print(allLines[i].text);
-            }
-            
-            // Add status in small font if present
-            if (allLines[i].status.length() > 0) {
-                display->setFont();  // Small default font
-                display->print(allLines[i].status);
-            }
-            
-            currentY -= lineHeight;  // Next line goes up
+            index--;
         }
     }
     
+    drawMessagingInputLine();
+}
+
+void UI::drawMessagingInputLine() {
+    // Cursor gets a full line at the bottom
+    int cursorY = SCREEN_HEIGHT - 4;  // Full line height baseline
+    
     // Cursor at the bottom with full line height
     display->setFont(&FreeSans9pt7b);
     display->setCursor(5, cursorY);
@@ -1478,31 +1531,165 @@ void UI::setInputComplete(bool complete) {
 
 // Messaging
 void UI::addMessage(const Message& msg) {
-    messageHistory.push_back(msg);
+    if (newerOutsideWindow > 0) {
+        // Reader is scrolled back into older pages - keep their place, the message
+        // is paged in from storage when they scroll forward again
+        newerOutsideWindow++;
+        Serial.println("[UI] Message queued outside window (" + String(newerOutsideWindow) + " newer)");
+        return;
+    }
+    
+    if (messageHistory.pushBack(msg)) {
+        olderExhausted = false;  // Oldest dropped out of the window - can be paged back in
+    }
     messageScrollOffset = 0;  // Reset scroll to show new message at bottom
     Serial.println("[UI] Message added. Total: " + String(messageHistory.size()));
 }
 
+void UI::postMessage(const Message& msg) {
+    xSemaphoreTake(postedLock, portMAX_DELAY);
+    if ((int)postedMessages.size() >= MAX_POSTED_MESSAGES) {
+        postedMessages.erase(postedMessages.begin());
+        postedDropped++;
+    }
+    postedMessages.push_back(msg);
+    xSemaphoreGive(postedLock);
+}
+
+void UI::applyPostedMessages() {
+    xSemaphoreTake(postedLock, portMAX_DELAY);
+    if (postedMessages.empty()) {
+        xSemaphoreGive(postedLock);
+        return;
+    }
+    std::vector<Message> posted;
+    posted.swap(postedMessages);
+    int dropped = postedDropped;
+    postedDropped = 0;
+    xSemaphoreGive(postedLock);
+    
+    if (dropped > 0) {
+        // The queue overflowed, so the retained messages fill the whole window on
+        // their own - account for the window and the dropped ones as paged out
+        Serial.println("[UI] " + String(dropped) + " posted messages dropped - left in storage");
+        if (newerOutsideWindow > 0) {
+            newerOutsideWindow += dropped;
+        } else {
+            messageHistory.clear();
+            olderExhausted = false;
+        }
+    }
+    
+    for (const Message& msg : posted) {
+        addMessage(msg);
+    }
+}
+
 void UI::clearMessages() {
+    // Reloading from storage - anything still posted is already in there
+    xSemaphoreTake(postedLock, portMAX_DELAY);
+    postedMessages.clear();
+    postedDropped = 0;
+    xSemaphoreGive(postedLock);
+    
     messageHistory.clear();
+    messageScrollOffset = 0;
+    newerOutsideWindow = 0;
+    olderExhausted = false;
 }
 
 void UI::scrollMessagesUp() {
     // UP = go back in time = show older messages
-    messageScrollOffset++;
+    if (messageScrollOffset + 1 >= messageHistory.size()) {
+        olderExhausted = false;  // Explicit scroll - check storage again (sync may have added some)
+        pageInOlder();  // At the oldest loaded message - fetch the previous page from storage
+    }
+    if (messageScrollOffset + 1 < messageHistory.size()) {
+        messageScrollOffset++;
+    }
 }
 
 void UI::scrollMessagesDown() {
     // DOWN = go forward in time = show newer messages
+    if (messageScrollOffset == 0 && newerOutsideWindow > 0) {
+        pageInNewer();  // At the newest loaded message but newer ones were evicted
+    }
     if (messageScrollOffset > 0) {
         messageScrollOffset--;
     }
 }
 
 void UI::resetMessageScroll() {
+    while (newerOutsideWindow > 0 && historyPageLoader) {
+        pageInNewer();
+    }
     messageScrollOffset = 0;
 }
 
+void UI::setHistoryPageLoader(std::vector<Message> (*loader)(unsigned long timestamp, uint32_t storeOffset, int count, bool older)) {
+    historyPageLoader = loader;
+}
+
+void UI::prepareMessagingDraw() {
+    if (currentState != STATE_MESSAGING) return;
+    
+    // A screen shows at most HISTORY_PAGE_SIZE messages above the anchor. Only page in
+    // when that fits without evicting messages already on screen
+    int olderThanAnchor = messageHistory.size() - 1 - messageScrollOffset;
+    if (olderThanAnchor < HISTORY_PAGE_SIZE &&
+        messageHistory.size() + HISTORY_PAGE_SIZE <= messageHistory.capacity()) {
+        pageInOlder();
+    }
+}
+
+int UI::pageInOlder() {
+    if (!historyPageLoader || olderExhausted || messageHistory.size() == 0) return 0;
+    
+    const HistoryEntry& oldest = messageHistory.at(0);
+    std::vector<Message> page = historyPageLoader(oldest.timestamp, oldest.storeOffset, HISTORY_PAGE_SIZE, true);
+    if (page.empty()) {
+        olderExhausted = true;  // Nothing older to show
+        return 0;
+    }
+    
+    // Prepend newest-first so the window stays in chronological order
+    for (int i = page.size() - 1; i >= 0; i--) {
+        if (messageHistory.pushFront(page[i])) {
+            // Newest dropped out - shift offset so the viewport stays on the same message
+            newerOutsideWindow++;
+            if (messageScrollOffset > 0) messageScrollOffset--;
+        }
+    }
+    
+    Serial.println("[UI] Paged in " + String(page.size()) + " older messages");
+    return page.size();
+}
+
+void UI::pageInNewer() {
+    if (!historyPageLoader || newerOutsideWindow <= 0 || messageHistory.size() == 0) return;
+    
+    const HistoryEntry& newest = messageHistory.at(messageHistory.size() - 1);
+    std::vector<Message> page = historyPageLoader(newest.timestamp, newest.storeOffset, HISTORY_PAGE_SIZE, false);
+    if (page.empty()) {
+        newerOutsideWindow = 0;  // Nothing newer in storage after all
+        return;
+    }
+    
+    for (const Message& msg : page) {
+        messageHistory.pushBack(msg);
+        messageScrollOffset++;  // Viewed message is now one further from the newest
+    }
+    olderExhausted = false;  // Oldest were evicted - they can be paged back in
+    // Only a hint - the store may hold more than counted (synced inserts), the next
+    // page request tells
+    newerOutsideWindow -= page.size();
+    if (newerOutsideWindow <= 0) {
+        newerOutsideWindow = (int)page.size() == HISTORY_PAGE_SIZE ? 1 : 0;
+    }
+    
+    Serial.println("[UI] Paged in " + String(page.size()) + " newer messages");
+}
+
 int UI::getMessageCount() const {
     return messageHistory.size();
 }
@@ -1518,10 +1705,22 @@ void UI::setExistingConversationName(const String& name) {
 
 void UI::setNetworkList(const std::vector<String>& ssids, const std::vector<int>& rssis, 
                         const std::vector<bool>& encrypted, const std::vector<bool>& saved) {
+    // Keep the highlighted network selected when a rescan reorders the list
+    String selectedSSID = getNetworkSSID(menuSelection);
+    
     networkSSIDs = ssids;
     networkRSSIs = rssis;
     networkEncrypted = encrypted;
     networkSaved = saved;
+    
+    int newIndex = 0;
+    for (int i = 0; i < (int)networkSSIDs.size(); i++) {
+        if (networkSSIDs[i] == selectedSSID) {
+            newIndex = i;
+            break;
+        }
+    }
+    menuSelection = newIndex;
 }
 
 // Display helpers
@@ -1810,6 +2009,13 @@ void UI::drawBatteryIcon(int x, int y, int percent) {
     display->setCursor(x - voltageStr.length() * 6 - 2, y + 2);  // Position to left, down 2px from icon
     display->print(voltageStr);
     
+    // Background status (WiFi connect / time sync) to the left of the voltage
+    if (statusText.length() > 0) {
+        String status = statusText.length() > 16 ? statusText.substring(0, 15) + "." : statusText;
+        display->setCursor(x - (voltageStr.length() + status.length() + 1) * 6 - 2, y + 2);
+        display->print(status);
+    }
+    
     // Draw battery body
     display->drawRect(x, y, width, height, GxEPD_BLACK);
     
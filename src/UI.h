@@ -12,6 +12,7 @@
 #include <Fonts/FreeSansBold24pt7b.h>
 #include "Messages.h"
 #include "Village.h"
+#include "MessageHistory.h"
 
 #define SCREEN_WIDTH 296
 #define SCREEN_HEIGHT 128
@@ -65,12 +66,53 @@ private:
     static const int MAX_PARTIAL_BEFORE_FULL = 12;   // force full after N partials
     static const unsigned long MAX_PARTIAL_AGE_MS = 15000; // or after 15s
     
+    // Frame scheduler - redraw requests are coalesced into at most one frame per interval
+    volatile bool framePending = false;  // Set from MQTT task, consumed in loop()
+    unsigned long lastFrameMs = 0;
+    static const unsigned long FRAME_INTERVAL_MS = 1000;  // Min gap between coalesced redraws
+    void beginFrame();      // Clears framePending - call before drawing, not after
+    void markFrameDrawn();
+    void refreshDisplay(bool partial);  // Push the frame buffer to the panel (timed for metrics)
+    
     int menuSelection;
     String inputText;
     bool inputComplete;
     
-    std::vector<Message> messageHistory;
-    int messageScrollOffset;
+    MessageHistory messageHistory;  // Bounded window over the message store
+    int messageScrollOffset;        // Messages skipped from the newest in the window
+    int newerOutsideWindow;         // Newer messages evicted while scrolled back
+    bool olderExhausted;            // Last older page came back empty - don't ask again before a scroll
+    std::vector<Message> (*historyPageLoader)(unsigned long timestamp, uint32_t storeOffset, int count, bool older);
+    static const int HISTORY_PAGE_SIZE = 10;  // Also covers one screen of messages (7 lines at most)
+    int pageInOlder();   // Returns number of messages prepended
+    void pageInNewer();
+    void prepareMessagingDraw();  // Page in what the next draw needs - no flash I/O mid-draw
+    
+    // Messages received on the MQTT task wait here until the loop task applies them -
+    // the history window is only ever touched from the loop task
+    static const int MAX_POSTED_MESSAGES = HISTORY_CAPACITY;  // More would evict each other anyway
+    SemaphoreHandle_t postedLock;
+    std::vector<Message> postedMessages;
+    int postedDropped;  // Oldest posted messages dropped because the queue was full
+    
+    // Messaging layout - one wrapped display line
+    struct DisplayLine {
+        String text;
+        String status;      // Empty or "(sent)", "(read)", etc.
+        bool isFirstLine;   // First line of message (sender name bold)
+        String senderPart;  // "You:" or "Name:" for bold rendering
+    };
+    void layoutMessage(const HistoryEntry& msg, int maxLineWidth, std::vector<DisplayLine>& messageLines);
+    void drawMessageLine(const DisplayLine& line, int leftMargin, int currentY);
+    
+    // Input line fast path - the bottom band of the messaging screen is refreshed on its
+    // own while typing. 24 rows = a whole number of panel bytes, so the partial window
+    // isn't widened; it also clips the lowest message line, which is redrawn from here
+    static const int INPUT_BAND_TOP = SCREEN_HEIGHT - 24;
+    DisplayLine bandLine;           // Lowest message line from the last full draw
+    int bandLineY;
+    bool hasBandLine;
+    void drawMessagingInputLine();
     
     std::vector<String> memberList;  // Store member list for display
     String existingConversationName;  // Store village name if one exists
@@ -78,6 +120,7 @@ private:
     String buildNumber;  // Build version to display
     float batteryVoltage;  // Current battery voltage
     int batteryPercent;    // Current battery percentage
+    String statusText;     // Background activity shown in the header (e.g. WiFi connecting)
     bool ringtoneEnabled;  // Ringtone on/off setting
     String ringtoneName;   // Current ringtone name
     
@@ -92,6 +135,7 @@ private:
     bool isWiFiConnected;
     int savedNetworkCount;  // Number of saved networks
     bool isNetworkActive;   // Track if displayed network is currently connected
+    bool isNetworkScanning; // Background scan running - list may be empty or stale
     
     // Invite code system
     String inviteCode;        // 8-digit code for inviting
@@ -142,6 +186,12 @@ public:
     void updatePartial();  // Partial refresh for smooth menu navigation
     void updateFull();     // Full-screen refresh (multi-phase waveform)
     void updateClean();    // Clear then draw - cleaner transitions than partial alone
+    void updateInputLine();  // Messaging: refresh only the input line (per keystroke)
+    
+    // Deferred redraw: mark dirty now, serviceFrame() draws once when the frame interval allows
+    void requestUpdate();
+    void serviceFrame();   // Call from loop()
+    bool hasPendingFrame() const { return framePending; }
     
     // Callback to check if user is typing (for deferring display updates)
     void setTypingCheckCallback(bool (*callback)());
@@ -166,12 +216,20 @@ public:
     void setInputComplete(bool complete);
     
     // Messaging
-    void addMessage(const Message& msg);
+    void addMessage(const Message& msg);    // Loop task only
+    void postMessage(const Message& msg);   // Any task - applied by applyPostedMessages()
+    void applyPostedMessages();             // Call from loop() before serviceFrame()
     void clearMessages();
     void scrollMessagesUp();
     void scrollMessagesDown();
     void resetMessageScroll();
     int getMessageCount() const;
+    
+    // History paging - the loader returns up to count stored messages of the current village
+    // right before (older) or after the given message, oldest first. Paging by the
+    // message's (timestamp, store offset) cursor keeps working when synced older
+    // messages are inserted into the store
+    void setHistoryPageLoader(std::vector<Message> (*loader)(unsigned long timestamp, uint32_t storeOffset, int count, bool older));
 
     
     // Member list
@@ -184,6 +242,7 @@ public:
     
     // Battery display
     void setBatteryStatus(float voltage, int percent);
+    void setStatusText(const String& text);  // Redraws (coalesced) only when the text changes
     void drawBatteryIcon(int x, int y, int percent);
     
     // Ringtone setting
@@ -196,6 +255,8 @@ public:
     void setNetworkList(const std::vector<String>& ssids, const std::vector<int>& rssis, 
                         const std::vector<bool>& encrypted, const std::vector<bool>& saved);
     int getNetworkCount() const { return networkSSIDs.size(); }
+    void setNetworkScanning(bool scanning) { isNetworkScanning = scanning; }
+    bool getNetworkScanning() const { return isNetworkScanning; }
     String getNetworkSSID(int index) const { return (index >= 0 && index < networkSSIDs.size()) ? networkSSIDs[index] : ""; }
     
     // WiFi connection status
@@ -1,5 +1,7 @@
 #include "Village.h"
 #include "Logger.h"
+#include "ConversationIndex.h"
+#include "Metrics.h"
 #include <Crypto.h>
 #include <SHA256.h>
 #include <RNG.h>
@@ -13,13 +15,20 @@ Village::Village() {
     memset(myUsername, 0, MAX_USERNAME);
     memset(encryptionKey, 0, KEY_SIZE);
     members.clear();
+    indexLock = xSemaphoreCreateMutex();
 
 // ...existing code...
 }
 
+Village::~Village() {
+    vSemaphoreDelete(indexLock);
+}
+
 // Stub implementation for saveToSlot
 bool Village::saveToSlot(int slot) {
     // TODO: Implement saving logic
+    setSlotInfo(slot, villageId, villageName);
+    conversationIndex.updateSlot(slot, String(villageId), String(villageName));
     return true;
 }
 
@@ -210,27 +219,11 @@ bool Village::loadFromFile() {
     return loadFromSlot(0);  // Default to slot 0
 }
 
-std::vector<String> Village::listVillages() {
-    std::vector<String> villages;
-    
-    if (!LittleFS.begin(true)) {
-        return villages;
-    }
-    
-    for (int i = 0; i < 10; i++) {
-        String name = getVillageNameFromSlot(i);
-        if (name.length() > 0) {
-            villages.push_back(String(i) + ": " + name);
-        }
-    }
-    
-    return villages;
-}
+VillageSlotInfo Village::slotRegistry[MAX_VILLAGE_SLOTS];
+bool Village::slotRegistryLoaded = false;
 
-bool Village::hasVillageInSlot(int slot) {
-    if (slot < 0 || slot > 9) return false;
-    
-    if (!LittleFS.begin(true)) return false;
+bool Village::readSlotFile(int slot, VillageSlotInfo& info) {
+    memset(&info, 0, sizeof(info));
     
     String filename = "/village_" + String(slot) + ".dat";
     if (!LittleFS.exists(filename)) return false;
@@ -259,68 +252,79 @@ bool Village::hasVillageInSlot(int slot) {
         return false;
     }
     
+    strncpy(info.villageId, doc["villageId"] | "", sizeof(info.villageId) - 1);
+    strncpy(info.villageName, doc["villageName"] | "", sizeof(info.villageName) - 1);
+    info.valid = true;
     return true;
 }
 
-String Village::getVillageNameFromSlot(int slot) {
-    if (slot < 0 || slot > 9) return "";
+void Village::loadSlotRegistry() {
+    if (slotRegistryLoaded) return;
     
-    if (!LittleFS.begin(true)) return "";
+    memset(slotRegistry, 0, sizeof(slotRegistry));
+    if (!LittleFS.begin(true)) return;  // Retried on next query
     
-    String filename = "/village_" + String(slot) + ".dat";
-    if (!LittleFS.exists(filename)) return "";
+    int count = 0;
+    for (int slot = 0; slot < MAX_VILLAGE_SLOTS; slot++) {
+        if (readSlotFile(slot, slotRegistry[slot])) count++;
+    }
+    slotRegistryLoaded = true;
     
-    File file = LittleFS.open(filename, "r");
-    if (!file) return "";
+    Serial.println("[Village] Slot registry loaded: " + String(count) + " villages");
+}
+
+void Village::refreshSlot(int slot) {
+    if (slot < 0 || slot >= MAX_VILLAGE_SLOTS) return;
+    loadSlotRegistry();
+    readSlotFile(slot, slotRegistry[slot]);
+}
+
+void Village::setSlotInfo(int slot, const char* id, const char* name) {
+    if (slot < 0 || slot >= MAX_VILLAGE_SLOTS) return;
+    loadSlotRegistry();
     
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
+    VillageSlotInfo& info = slotRegistry[slot];
+    memset(&info, 0, sizeof(info));
+    strncpy(info.villageId, id, sizeof(info.villageId) - 1);
+    strncpy(info.villageName, name, sizeof(info.villageName) - 1);
+    info.valid = true;
+}
+
+std::vector<String> Village::listVillages() {
+    std::vector<String> villages;
+    loadSlotRegistry();
     
-    if (error) return "";
+    for (int i = 0; i < MAX_VILLAGE_SLOTS; i++) {
+        if (slotRegistry[i].valid && slotRegistry[i].villageName[0] != '\0') {
+            villages.push_back(String(i) + ": " + String(slotRegistry[i].villageName));
+        }
+    }
     
-    return doc["villageName"].as<String>();
+    return villages;
+}
+
+bool Village::hasVillageInSlot(int slot) {
+    if (slot < 0 || slot >= MAX_VILLAGE_SLOTS) return false;
+    loadSlotRegistry();
+    return slotRegistry[slot].valid;
+}
+
+String Village::getVillageNameFromSlot(int slot) {
+    if (!hasVillageInSlot(slot)) return "";
+    return String(slotRegistry[slot].villageName);
 }
 
 String Village::getVillageIdFromSlot(int slot) {
-    if (slot < 0 || slot > 9) return "";
-    
-    if (!LittleFS.begin(true)) return "";
-    
-    String filename = "/village_" + String(slot) + ".dat";
-    if (!LittleFS.exists(filename)) return "";
-    
-    File file = LittleFS.open(filename, "r");
-    if (!file) return "";
-    
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    
-    if (error) return "";
-    
-    return doc["villageId"].as<String>();
+    if (!hasVillageInSlot(slot)) return "";
+    return String(slotRegistry[slot].villageId);
 }
 
 int Village::findVillageSlotById(const String& villageId) {
-    if (!LittleFS.begin(true)) return -1;
+    loadSlotRegistry();
     
     // Check each slot for matching village ID
-    for (int slot = 0; slot < 10; slot++) {
-        String filename = "/village_" + String(slot) + ".dat";
-        if (!LittleFS.exists(filename)) continue;
-        
-        File file = LittleFS.open(filename, "r");
-        if (!file) continue;
-        
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, file);
-        file.close();
-        
-        if (error) continue;
-        
-        String slotVillageId = doc["villageId"].as<String>();
-        if (slotVillageId == villageId) {
+    for (int slot = 0; slot < MAX_VILLAGE_SLOTS; slot++) {
+        if (slotRegistry[slot].valid && villageId == slotRegistry[slot].villageId) {
             Serial.println("[Village] Found existing village with ID '" + villageId + "' in slot " + String(slot));
             return slot;
         }
@@ -331,7 +335,7 @@ int Village::findVillageSlotById(const String& villageId) {
 }
 
 void Village::deleteSlot(int slot) {
-    if (slot < 0 || slot > 9) return;
+    if (slot < 0 || slot >= MAX_VILLAGE_SLOTS) return;
     
     if (!LittleFS.begin(true)) return;
     
@@ -340,6 +344,11 @@ void Village::deleteSlot(int slot) {
     
     String msgFilename = "/messages_" + String(slot) + ".dat";
     LittleFS.remove(msgFilename);
+    
+    loadSlotRegistry();
+    memset(&slotRegistry[slot], 0, sizeof(VillageSlotInfo));
+    
+    conversationIndex.removeSlot(slot);
 }
 
 void Village::clearVillage() {
@@ -366,7 +375,7 @@ void Village::setVillageName(const String& name) {
     }
 }
 
-bool Village::saveMessage(const Message& msg) {
+bool Village::saveMessage(const Message& msg, uint32_t* storeOffset) {
     if (!initialized) {
         logger.error("Save message failed: village not initialized");
         return false;
@@ -374,16 +383,21 @@ bool Village::saveMessage(const Message& msg) {
     
     // Check for duplicate message ID (skip empty IDs from old messages)
     if (!msg.messageId.isEmpty() && messageIdExists(msg.messageId)) {
+        metrics.increment(CTR_STORE_DUPLICATE);
         logger.info("Duplicate message skipped: id=" + msg.messageId);
         return true;  // Return true as it's not an error, message already exists
     }
     
+    // Only the write path is timed - rejected and duplicate calls aren't saves
+    MetricTimer timer(HIST_SAVE_MESSAGE);
+    
     File file = LittleFS.open("/messages.dat", "a");
     if (!file) {
         logger.critical("Failed to open messages.dat for writing");
         Serial.println("[Village] Failed to open messages file");
         return false;
     }
+    uint32_t lineOffset = file.size();  // Append position, for the history index
     
     JsonDocument doc;
     doc["village"] = villageId;  // Use UUID for stable filtering
@@ -404,6 +418,20 @@ bool Village::saveMessage(const Message& msg) {
     if (!msg.messageId.isEmpty()) {
         messageIdCache.insert(msg.messageId);
     }
+    if (storeOffset) *storeOffset = lineOffset;
+    
+    // Keep the history index in timestamp order (synced messages can be older)
+    xSemaphoreTake(indexLock, portMAX_DELAY);
+    if (indexedVillageId == villageId) {
+        MessageIndexEntry entry = { (uint32_t)msg.timestamp, lineOffset };
+        auto pos = std::upper_bound(messageIndex.begin(), messageIndex.end(), entry,
+            [](const MessageIndexEntry& a, const MessageIndexEntry& b) { return a.timestamp < b.timestamp; });
+        messageIndex.insert(pos, entry);
+    }
+    xSemaphoreGive(indexLock);
+    
+    conversationIndex.recordMessage(String(villageId), msg);
+    metrics.increment(CTR_MESSAGES_SAVED);
     
     logger.info("Message saved: id=" + msg.messageId + " from=" + msg.sender + " village=" + String(villageId));
     return true;
@@ -440,11 +468,14 @@ bool Village::saveMessageToFile(const Message& msg) {
     file.flush();  // CRITICAL: Ensure data is written to disk before closing
     file.close();
     
+    conversationIndex.recordMessage(msg.villageId, msg);
+    
     Serial.println("[Village] Message saved to file: id=" + msg.messageId + " village=" + msg.villageId);
     return true;
 }
 
 std::vector<Message> Village::loadMessages() {
+    MetricTimer timer(HIST_LOAD_MESSAGES);
     std::vector<Message> messages;
     
     if (!initialized) {
@@ -528,6 +559,11 @@ std::vector<Message> Village::loadMessages() {
 bool Village::clearMessages() {
     if (!initialized) return false;
     
+    xSemaphoreTake(indexLock, portMAX_DELAY);
+    messageIndex.clear();
+    indexedVillageId = "";
+    xSemaphoreGive(indexLock);
+    
     if (LittleFS.remove("/messages.dat")) {
         Serial.println("[Village] Messages cleared");
         return true;
@@ -542,6 +578,144 @@ bool Village::clearMessages() {
 
 
 
+void Village::ensureMessageIndex() {
+    if (!initialized) {
+        messageIndex.clear();
+        indexedVillageId = "";
+        return;
+    }
+    if (indexedVillageId == villageId) return;  // Still valid for this village
+    
+    messageIndex.clear();
+    indexedVillageId = villageId;
+    
+    File file = LittleFS.open("/messages.dat", "r");
+    if (!file) return;
+    
+    // Only pull the two fields we need out of each line
+    JsonDocument filter;
+    filter["village"] = true;
+    filter["timestamp"] = true;
+    
+    while (file.available()) {
+        uint32_t offset = file.position();
+        String line = file.readStringUntil('\n');
+        line.trim();
+        if (line.length() == 0) continue;
+        
+        JsonDocument doc;
+        if (deserializeJson(doc, line, DeserializationOption::Filter(filter))) continue;
+        
+        const char* msgVillage = doc["village"] | "";
+        if (strcmp(msgVillage, villageId) != 0) continue;
+        
+        MessageIndexEntry entry = { (uint32_t)(doc["timestamp"] | 0UL), offset };
+        messageIndex.push_back(entry);
+    }
+    file.close();
+    
+    std::stable_sort(messageIndex.begin(), messageIndex.end(), [](const MessageIndexEntry& a, const MessageIndexEntry& b) {
+        return a.timestamp < b.timestamp;
+    });
+    
+    logger.info("Built message index: " + String(messageIndex.size()) + " messages");
+}
+
+bool Village::parseMessageLine(const String& line, Message& msg) {
+    JsonDocument doc;
+    if (deserializeJson(doc, line)) return false;
+    
+    msg.sender = doc["sender"] | "";
+    msg.senderMAC = doc["senderMAC"] | "";
+    msg.content = doc["content"] | "";
+    msg.timestamp = doc["timestamp"] | 0;
+    msg.received = doc["received"] | false;
+    msg.status = (MessageStatus)(doc["status"] | MSG_SENT);
+    msg.messageId = doc["messageId"] | "";
+    msg.villageId = doc["village"] | "";
+    return true;
+}
+
+int Village::getStoredMessageCount() {
+    xSemaphoreTake(indexLock, portMAX_DELAY);
+    ensureMessageIndex();
+    int count = messageIndex.size();
+    xSemaphoreGive(indexLock);
+    return count;
+}
+
+unsigned long Village::getLatestMessageTimestamp() {
+    xSemaphoreTake(indexLock, portMAX_DELAY);
+    ensureMessageIndex();
+    unsigned long latest = messageIndex.empty() ? 0 : messageIndex.back().timestamp;
+    xSemaphoreGive(indexLock);
+    return latest;
+}
+
+std::vector<Message> Village::readIndexRange(int startIndex, int endIndex) {
+    std::vector<Message> messages;
+    
+    if (startIndex < 0) startIndex = 0;
+    if (endIndex > (int)messageIndex.size()) endIndex = messageIndex.size();
+    if (startIndex >= endIndex) return messages;
+    
+    MetricTimer timer(HIST_LOAD_MESSAGES);
+    File file = LittleFS.open("/messages.dat", "r");
+    if (!file) return messages;
+    
+    // Seek straight to each indexed line - cost scales with the page, not the file
+    for (int i = startIndex; i < endIndex; i++) {
+        if (!file.seek(messageIndex[i].offset)) continue;
+        String line = file.readStringUntil('\n');
+        line.trim();
+        
+        Message msg;
+        if (parseMessageLine(line, msg)) {
+            msg.storeOffset = messageIndex[i].offset;
+            messages.push_back(msg);
+        }
+    }
+    file.close();
+    
+    return messages;
+}
+
+std::vector<Message> Village::loadMessageRange(int startIndex, int count) {
+    xSemaphoreTake(indexLock, portMAX_DELAY);
+    ensureMessageIndex();
+    std::vector<Message> messages = readIndexRange(startIndex, startIndex + count);
+    xSemaphoreGive(indexLock);
+    return messages;
+}
+
+static bool indexEntryLess(const MessageIndexEntry& a, const MessageIndexEntry& b) {
+    return a.timestamp < b.timestamp || (a.timestamp == b.timestamp && a.offset < b.offset);
+}
+
+std::vector<Message> Village::loadMessagesBefore(unsigned long timestamp, uint32_t storeOffset, int count) {
+    xSemaphoreTake(indexLock, portMAX_DELAY);
+    ensureMessageIndex();
+    
+    // First entry at or after the cursor - everything before it is older
+    MessageIndexEntry cursor = { (uint32_t)timestamp, storeOffset == MESSAGE_OFFSET_UNKNOWN ? 0 : storeOffset };
+    int end = std::lower_bound(messageIndex.begin(), messageIndex.end(), cursor, indexEntryLess) - messageIndex.begin();
+    std::vector<Message> messages = readIndexRange(end - count, end);
+    xSemaphoreGive(indexLock);
+    return messages;
+}
+
+std::vector<Message> Village::loadMessagesAfter(unsigned long timestamp, uint32_t storeOffset, int count) {
+    xSemaphoreTake(indexLock, portMAX_DELAY);
+    ensureMessageIndex();
+    
+    // First entry past the cursor (unknown offset sorts after every same-timestamp entry)
+    MessageIndexEntry cursor = { (uint32_t)timestamp, storeOffset };
+    int start = std::upper_bound(messageIndex.begin(), messageIndex.end(), cursor, indexEntryLess) - messageIndex.begin();
+    std::vector<Message> messages = readIndexRange(start, start + count);
+    xSemaphoreGive(indexLock);
+    return messages;
+}
+
 bool Village::messageIdExists(const String& messageId) {
     if (messageId.isEmpty()) return false;
     return messageIdCache.find(messageId) != messageIdCache.end();
@@ -13,6 +13,22 @@
 #define MAX_PASSWORD 64
 #define MAX_MEMBERS 20
 #define KEY_SIZE 32  // 256-bit key for ChaCha20
+#define MAX_VILLAGE_SLOTS 10
+
+// Position of one stored message in messages.dat (history cursor index).
+// (timestamp, offset) is unique and ordered, so it stays a valid cursor when older
+// synced messages are inserted into the index
+struct MessageIndexEntry {
+    uint32_t timestamp;
+    uint32_t offset;  // Byte offset of the message's JSON line
+};
+
+// Cached metadata for one /village_N.dat slot (see Village slot registry)
+struct VillageSlotInfo {
+    bool valid;  // File exists, parses and has the critical fields
+    char villageId[37];
+    char villageName[MAX_VILLAGE_NAME];
+};
 
 struct Member {
     char username[MAX_USERNAME];
@@ -37,6 +53,7 @@ private:
     
 public:
     Village();
+    ~Village();
     
     // Village management
     bool createVillage(const String& name);
@@ -87,11 +104,25 @@ public:
     static int findVillageSlotById(const String& villageId);  // Find slot with matching village ID
     static void deleteSlot(int slot);  // Delete village in slot
     
+    // Slot registry - slot metadata is read once and served from RAM afterwards
+    static void loadSlotRegistry();  // Call once at boot (queries also load it lazily)
+    static void refreshSlot(int slot);  // Re-read one slot after writing its file directly
+    
     // Message persistence
-    bool saveMessage(const Message& msg);
+    bool saveMessage(const Message& msg, uint32_t* storeOffset = nullptr);  // storeOffset: where it was written
     static bool saveMessageToFile(const Message& msg);  // Static method to save without loading village
     std::vector<Message> loadMessages();
     bool clearMessages();  // Clear all stored messages
+    
+    // History cursor - random access to this village's stored messages in timestamp
+    // order, reading only the requested lines instead of the whole file
+    int getStoredMessageCount();
+    std::vector<Message> loadMessageRange(int startIndex, int count);
+    // Up to count messages right before / after a message, oldest first. An unknown
+    // offset (MESSAGE_OFFSET_UNKNOWN) matches by timestamp only
+    std::vector<Message> loadMessagesBefore(unsigned long timestamp, uint32_t storeOffset, int count);
+    std::vector<Message> loadMessagesAfter(unsigned long timestamp, uint32_t storeOffset, int count);
+    unsigned long getLatestMessageTimestamp();
 
 
     bool messageIdExists(const String& messageId);  // Check if message already saved
@@ -101,6 +132,17 @@ public:
     
 private:
     std::set<String> messageIdCache;  // In-memory cache of message IDs for deduplication
+    std::vector<MessageIndexEntry> messageIndex;  // Sorted by timestamp, 8 bytes per message
+    String indexedVillageId;  // Village the index was built for (empty = needs rebuild)
+    SemaphoreHandle_t indexLock;  // saveMessage() inserts on the MQTT task, paging reads on the loop task
+    void ensureMessageIndex();                                    // indexLock held
+    std::vector<Message> readIndexRange(int startIndex, int endIndex);  // indexLock held
+    static bool parseMessageLine(const String& line, Message& msg);
+    
+    static VillageSlotInfo slotRegistry[MAX_VILLAGE_SLOTS];
+    static bool slotRegistryLoaded;
+    static bool readSlotFile(int slot, VillageSlotInfo& info);
+    static void setSlotInfo(int slot, const char* id, const char* name);
 };
 
 #endif
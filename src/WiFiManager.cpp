@@ -1,13 +1,42 @@
 #include "WiFiManager.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/dhcp.h>
+
+// Lease length the DHCP server granted on the station interface, 0 = unknown
+static uint32_t stationLeaseSeconds() {
+    esp_netif_t* netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (!netif) return 0;
+    struct netif* lwipNetif = (struct netif*)esp_netif_get_netif_impl(netif);
+    if (!lwipNetif) return 0;
+    struct dhcp* dhcp = netif_dhcp_data(lwipNetif);
+    return dhcp ? dhcp->offered_t0_lease : 0;
+}
 
 WiFiManager::WiFiManager() {
     state = WIFI_DISCONNECTED;
     autoReconnect = true;
     lastReconnectAttempt = 0;
     reconnectInterval = 30000; // 30 seconds between reconnect attempts
-    connectionAttempts = 0;
     lastNTPSync = 0;
     timeOffset = 0;
+    connectPhase = CONNECT_IDLE;
+    attemptStart = 0;
+    attemptFailed = false;
+    attemptUsesLease = false;
+    leaseStampPending = false;
+    leaseAcquiredMs = 0;
+    rememberAttempt = false;
+    linkLost = false;
+    eventsRegistered = false;
+    ntpSyncing = false;
+    ntpStart = 0;
+    scanInProgress = false;
+    connectAfterScan = false;
+    lastScanTime = 0;
+    scanGeneration = 0;
 }
 
 bool WiFiManager::begin() {
@@ -15,12 +44,21 @@ bool WiFiManager::begin() {
     WiFi.setAutoReconnect(false); // We'll handle reconnection ourselves
     WiFi.setHostname("SmolTxt"); // Set device hostname for network identification
     
+    // Connection progress comes from driver events instead of polling loops
+    if (!eventsRegistered) {
+        WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info) { onWiFiEvent(event, info); });
+        eventsRegistered = true;
+    }
+    
     // Open preferences for WiFi credentials
     if (!prefs.begin("wifi", false)) {
         Serial.println("[WiFi] Failed to initialize preferences");
         return false;
     }
     
+    // Fast reconnect cache lives in its own namespace
+    fastPrefs.begin("wifi_fast", false);
+    
     // Load saved networks from preferences
     loadSavedNetworks();
     
@@ -110,6 +148,9 @@ bool WiFiManager::removeNetwork(const String& ssid) {
     for (auto it = savedNetworks.begin(); it != savedNetworks.end(); ++it) {
         if (it->ssid == ssid) {
             Serial.println("[WiFi] Removing network: " + ssid);
+            if (fastPrefs.getString("ssid", "") == ssid) {
+                clearFastConnectCache();
+            }
             savedNetworks.erase(it);
             saveSavedNetworks();
             return true;
@@ -140,16 +181,60 @@ int WiFiManager::getSavedNetworkCount() {
     return savedNetworks.size();
 }
 
-// Scan for available WiFi networks
+// Blocking scan - kept for callers that need fresh results immediately
 std::vector<ScannedNetwork> WiFiManager::scanNetworks() {
-    scannedNetworks.clear();
+    startScan();
+    while (scanInProgress) {
+        updateScan();
+        delay(50);
+    }
+    return getScanResults();
+}
+
+// Start a background scan; update() collects the results when the driver finishes.
+// Returns false if a scan can't run right now (already scanning or mid-connect).
+bool WiFiManager::startScan() {
+    if (scanInProgress) return true;
+    if (connectPhase != CONNECT_IDLE) return false;  // Scanning would disturb association
+    
+    Serial.println("[WiFi] Scanning for networks (background)...");
+    int result = WiFi.scanNetworks(true);  // async
+    if (result == WIFI_SCAN_FAILED) {
+        Serial.println("[WiFi] Scan failed to start");
+        return false;
+    }
+    scanInProgress = true;
+    return true;
+}
+
+void WiFiManager::updateScan() {
+    int n = WiFi.scanComplete();
+    if (n == WIFI_SCAN_RUNNING) return;
     
-    Serial.println("[WiFi] Scanning for networks...");
-    int n = WiFi.scanNetworks();
+    scanInProgress = false;
+    if (n == WIFI_SCAN_FAILED) {
+        Serial.println("[WiFi] Scan failed");
+        return;
+    }
+    
+    collectScanResults(n);
+    WiFi.scanDelete();  // Free the driver's result buffer
+    lastScanTime = millis();
+    scanGeneration++;
+    
+    // A connect that was waiting on the scan can now use its results
+    if (connectAfterScan) {
+        connectAfterScan = false;
+        beginConnect();
+    }
+}
+
+void WiFiManager::collectScanResults(int n) {
+    scannedNetworks.clear();
     
     if (n == 0) {
         Serial.println("[WiFi] No networks found");
-        return scannedNetworks;
+        return;
     }
     
     Serial.println("[WiFi] Found " + String(n) + " networks:");
@@ -190,10 +275,29 @@ std::vector<ScannedNetwork> WiFiManager::scanNetworks() {
         Serial.print(net.encrypted ? "[Secured]" : "[Open]");
         Serial.println(net.saved ? " [Saved]" : "");
     }
-    
+}
+
+// Cached results from the last completed scan, with saved flags refreshed
+// (networks may have been saved or removed since the scan)
+std::vector<ScannedNetwork> WiFiManager::getScanResults() {
+    for (auto& net : scannedNetworks) {
+        net.saved = hasNetwork(net.ssid);
+    }
     return scannedNetworks;
 }
 
+bool WiFiManager::hasFreshScan() const {
+    return lastScanTime > 0 && millis() - lastScanTime < SCAN_CACHE_MAX_AGE;
+}
+
+// Signal strength from the cached scan, or -999 if the SSID wasn't seen
+int WiFiManager::getScannedRSSI(const String& ssid) const {
+    for (const auto& net : scannedNetworks) {
+        if (net.ssid == ssid) return net.rssi;
+    }
+    return -999;
+}
+
 int WiFiManager::getScannedNetworkCount() {
     return scannedNetworks.size();
 }
@@ -210,6 +314,7 @@ bool WiFiManager::saveCredentials(const String& ssid, const String& password) {
 void WiFiManager::clearCredentials() {
     savedNetworks.clear();
     saveSavedNetworks();
+    clearFastConnectCache();
     Serial.println("[WiFi] All credentials cleared");
 }
 
@@ -229,41 +334,79 @@ String WiFiManager::getLastConnectedSSID() {
     return prefs.getString("last", "");
 }
 
-// Waterfall connection: try last successful, then all saved networks
+// Waterfall connection: cached AP first, then last successful, then all saved networks.
+// Blocking wrapper around the state machine - used by the UI flows that wait on the result.
 bool WiFiManager::connect() {
+    beginConnect();
+    waitForConnect();
+    return isConnected();
+}
+
+// Start a background waterfall connect; update() advances it
+void WiFiManager::beginConnect() {
+    if (connectPhase != CONNECT_IDLE) return;  // Already in progress
+    if (scanInProgress) {
+        connectAfterScan = true;  // Associating mid-scan fails - start when it completes
+        return;
+    }
+    
+    if (WiFi.status() == WL_CONNECTED) {
+        state = WIFI_CONNECTED;
+        if (lastNTPSync == 0 && !ntpSyncing) {
+            beginNTPSync();
+        }
+        return;
+    }
+    
     if (savedNetworks.size() == 0) {
         Serial.println("[WiFi] No saved networks");
         state = WIFI_FAILED;
-        return false;
+        return;
     }
     
-    // Try last successful network first for faster reconnect
+    // Queue the waterfall: last successful network first for faster reconnect
+    connectQueue.clear();
     String lastSSID = getLastConnectedSSID();
-    if (lastSSID.length() > 0) {
-        Serial.println("[WiFi] Trying last connected network: " + lastSSID);
-        if (connectToNetwork(lastSSID)) {
-            return true;
+    for (const auto& net : savedNetworks) {
+        if (net.ssid == lastSSID) {
+            connectQueue.push_back(net);
         }
     }
-    
-    // Try all saved networks in order
-    Serial.println("[WiFi] Waterfall connecting through " + String(savedNetworks.size()) + " saved networks");
-    
     for (const auto& net : savedNetworks) {
-        if (net.ssid == lastSSID) continue;  // Already tried this one
-        
-        Serial.println("[WiFi] Trying: " + net.ssid);
-        if (connectToSavedNetwork(net)) {
-            return true;
+        if (net.ssid != lastSSID) {
+            connectQueue.push_back(net);
         }
     }
     
-    Serial.println("[WiFi] Failed to connect to any saved network");
-    state = WIFI_FAILED;
-    return false;
+    // With a recent scan, only try saved networks that are actually in range, strongest
+    // first after the last one used. If none were seen (hidden SSID?) try them all.
+    if (hasFreshScan()) {
+        std::vector<SavedNetwork> inRange;
+        for (const auto& net : connectQueue) {
+            if (getScannedRSSI(net.ssid) > -999) {
+                inRange.push_back(net);
+            }
+        }
+        if (!inRange.empty()) {
+            std::stable_sort(inRange.begin(), inRange.end(), [this, &lastSSID](const SavedNetwork& a, const SavedNetwork& b) {
+                if (a.ssid == lastSSID || b.ssid == lastSSID) return a.ssid == lastSSID && b.ssid != lastSSID;
+                return getScannedRSSI(a.ssid) > getScannedRSSI(b.ssid);
+            });
+            Serial.println("[WiFi] " + String(inRange.size()) + " of " + String(connectQueue.size()) + " saved networks in range");
+            connectQueue = inRange;
+        }
+    }
+    rememberAttempt = true;
+    
+    Serial.println("[WiFi] Waterfall connecting through " + String(connectQueue.size()) + " saved networks");
+    
+    // Directed connect to the last AP with its cached lease - no scan, no DHCP
+    if (!startCachedAttempt()) {
+        startNextAttempt();
+    }
 }
 
-// Connect to a specific saved network by SSID
+// Blocking: connect to a specific saved network by SSID
 bool WiFiManager::connectToNetwork(const String& ssid) {
     for (const auto& net : savedNetworks) {
         if (net.ssid == ssid) {
@@ -275,58 +418,248 @@ bool WiFiManager::connectToNetwork(const String& ssid) {
     return false;
 }
 
-// Internal: connect to a SavedNetwork struct
-bool WiFiManager::connectToSavedNetwork(const SavedNetwork& network) {
-    bool success = connectWithCredentials(network.ssid, network.password);
-    if (success) {
-        saveLastConnectedSSID(network.ssid);
+// Directed connect using the cached BSSID, channel and lease. Skips the channel scan and,
+// while the lease is fresh, DHCP - together most of the association time.
+// Returns false (nothing started) if there is no usable cache entry.
+bool WiFiManager::startCachedAttempt() {
+    String ssid = fastPrefs.getString("ssid", "");
+    if (ssid.length() == 0) return false;
+    
+    const SavedNetwork* network = nullptr;
+    for (const auto& net : savedNetworks) {
+        if (net.ssid == ssid) {
+            network = &net;
+            break;
+        }
+    }
+    
+    int32_t channel = fastPrefs.getInt("chan", 0);
+    if (!network || fastPrefs.getBytes("bssid", cachedBSSID, sizeof(cachedBSSID)) != sizeof(cachedBSSID) || channel <= 0) {
+        clearFastConnectCache();
+        return false;
     }
-    return success;
+    
+    // Reuse the last DHCP lease as a static config while it is young enough - past that
+    // the connect runs DHCP, which renews it with the router and refreshes the cache
+    attemptUsesLease = cachedLeaseFresh();
+    if (attemptUsesLease) {
+        WiFi.config(IPAddress(fastPrefs.getUInt("ip", 0)), IPAddress(fastPrefs.getUInt("gw", 0)),
+                    IPAddress(fastPrefs.getUInt("mask", 0)), IPAddress(fastPrefs.getUInt("dns", 0)));
+    } else {
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+    
+    Serial.println("[WiFi] Fast connect to " + ssid + " on channel " + String(channel) +
+                   (attemptUsesLease ? " (cached lease)" : " (DHCP)"));
+    currentAttempt = *network;
+    connectPhase = CONNECT_CACHED;
+    state = WIFI_CONNECTING;
+    attemptFailed = false;
+    attemptStart = millis();
+    WiFi.begin(network->ssid.c_str(), network->password.c_str(), channel, cachedBSSID);
+    return true;
 }
 
-bool WiFiManager::connectWithCredentials(const String& ssid, const String& password) {
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("[WiFi] Already connected");
-        state = WIFI_CONNECTED;
-        return true;
+// Start the next queued network, or give up when the queue is empty
+void WiFiManager::startNextAttempt() {
+    if (connectQueue.empty()) {
+        Serial.println("[WiFi] Failed to connect to any saved network");
+        connectPhase = CONNECT_IDLE;
+        state = WIFI_FAILED;
+        return;
     }
     
-    Serial.println("[WiFi] Connecting to: " + ssid);
+    currentAttempt = connectQueue.front();
+    connectQueue.erase(connectQueue.begin());
+    
+    Serial.println("[WiFi] Connecting to: " + currentAttempt.ssid);
+    connectPhase = CONNECT_NETWORK;
     state = WIFI_CONNECTING;
-    connectionAttempts = 0;
+    attemptFailed = false;
+    attemptUsesLease = false;
+    attemptStart = millis();
     
-    WiFi.begin(ssid.c_str(), password.c_str());
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);  // Drop any cached static lease - use DHCP
+    WiFi.begin(currentAttempt.ssid.c_str(), currentAttempt.password.c_str());
+}
+
+// Advance the current attempt: success, driver-reported failure, or timeout
+void WiFiManager::advanceConnect() {
+    if (WiFi.status() == WL_CONNECTED) {
+        finishConnect();
+        return;
+    }
     
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - startTime < CONNECTION_TIMEOUT) {
-        delay(500);
-        Serial.print(".");
-        connectionAttempts++;
-        
-        if (connectionAttempts > MAX_CONNECTION_ATTEMPTS * 10) {
-            break;
+    unsigned long timeout = (connectPhase == CONNECT_CACHED) ? FAST_CONNECT_TIMEOUT : CONNECTION_TIMEOUT;
+    if (!attemptFailed && millis() - attemptStart < timeout) {
+        return;  // Still associating
+    }
+    
+    if (connectPhase == CONNECT_CACHED) {
+        WiFi.disconnect();
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);  // Back to DHCP
+        if (attemptUsesLease) {
+            // The reused lease may be what failed - one more directed try, with DHCP
+            Serial.println("[WiFi] Fast connect with cached lease failed - retrying with DHCP");
+            fastPrefs.remove("ip");
+            if (startCachedAttempt()) return;
         }
+        // AP moved or changed channel - back to the full waterfall
+        Serial.println("[WiFi] Fast connect failed - clearing cache");
+        clearFastConnectCache();
+    } else {
+        Serial.println("[WiFi] Connection failed: " + currentAttempt.ssid);
+        WiFi.disconnect();
+    }
+    startNextAttempt();
+}
+
+void WiFiManager::finishConnect() {
+    unsigned long elapsed = millis() - attemptStart;
+    metrics.record(HIST_WIFI_CONNECT, elapsed * 1000);
+    Serial.println("[WiFi] Connected in " + String(elapsed) + "ms");
+    Serial.println("[WiFi] IP: " + WiFi.localIP().toString());
+    Serial.println("[WiFi] RSSI: " + String(WiFi.RSSI()) + " dBm");
+    
+    state = WIFI_CONNECTED;
+    connectQueue.clear();
+    
+    if (rememberAttempt) {
+        saveLastConnectedSSID(currentAttempt.ssid);
+    }
+    
+    // Remember AP, channel and lease for a directed reconnect next time
+    // (a reused lease is already cached)
+    if (!attemptUsesLease) {
+        saveFastConnectCache();
+    }
+    connectPhase = CONNECT_IDLE;
+    
+    // Sync NTP time after successful connection
+    beginNTPSync();
+}
+
+// Block until the current connect (and the NTP sync that follows it) finishes
+void WiFiManager::waitForConnect() {
+    while (connectPhase != CONNECT_IDLE || ntpSyncing) {
+        update();
+        delay(20);
+    }
+}
+
+void WiFiManager::onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    // Runs on the WiFi event task - only set flags, update() does the work
+    if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        uint8_t reason = info.wifi_sta_disconnected.reason;
+        if (connectPhase != CONNECT_IDLE &&
+            (reason == WIFI_REASON_NO_AP_FOUND || reason == WIFI_REASON_AUTH_FAIL ||
+             reason == WIFI_REASON_ASSOC_FAIL || reason == WIFI_REASON_HANDSHAKE_TIMEOUT ||
+             reason == WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT)) {
+            attemptFailed = true;  // Don't wait out the full timeout
+        }
+        linkLost = true;
+    }
+}
+
+void WiFiManager::saveFastConnectCache() {
+    if (WiFi.status() != WL_CONNECTED || WiFi.BSSID() == nullptr) return;
+    
+    fastPrefs.putString("ssid", WiFi.SSID());
+    fastPrefs.putBytes("bssid", WiFi.BSSID(), 6);
+    fastPrefs.putInt("chan", WiFi.channel());
+    fastPrefs.putUInt("ip", (uint32_t)WiFi.localIP());
+    fastPrefs.putUInt("gw", (uint32_t)WiFi.gatewayIP());
+    fastPrefs.putUInt("mask", (uint32_t)WiFi.subnetMask());
+    fastPrefs.putUInt("dns", (uint32_t)WiFi.dnsIP());
+    uint32_t leaseSeconds = stationLeaseSeconds();
+    if (leaseSeconds == 0) leaseSeconds = FAST_LEASE_DEFAULT_S;
+    fastPrefs.putUInt("lease", leaseSeconds);
+    
+    // Lease start in wall-clock time, so the age still counts across deep sleep. Right
+    // after a cold boot the clock isn't set yet - advanceNTPSync() fills it in
+    time_t now = time(nullptr);
+    leaseStampPending = now < CLOCK_VALID_AFTER;
+    leaseAcquiredMs = millis();
+    fastPrefs.putUInt("leased", leaseStampPending ? 0 : (uint32_t)now);
+    Serial.println("[WiFi] Fast connect cache updated (" + WiFi.BSSIDstr() + ", ch " + String(WiFi.channel()) + ")");
+}
+
+void WiFiManager::clearFastConnectCache() {
+    fastPrefs.clear();
+    leaseStampPending = false;
+}
+
+// The cached lease may be reused until half its length has passed - T1, where a DHCP
+// client would renew it. Unknown start time (clock never synced) = not reusable
+bool WiFiManager::cachedLeaseFresh() {
+    uint32_t leasedAt = fastPrefs.getUInt("leased", 0);
+    if (fastPrefs.getUInt("ip", 0) == 0 || leasedAt == 0) return false;
+    
+    time_t now = time(nullptr);
+    if (now < CLOCK_VALID_AFTER || (uint32_t)now < leasedAt) return false;
+    return (uint32_t)now - leasedAt < fastPrefs.getUInt("lease", FAST_LEASE_DEFAULT_S) / 2;
+}
+
+// Internal: connect to a SavedNetwork struct
+bool WiFiManager::connectToSavedNetwork(const SavedNetwork& network) {
+    if (connectPhase != CONNECT_IDLE) {
+        waitForConnect();  // Let a background attempt finish first
+    }
+    if (WiFi.status() == WL_CONNECTED) {
+        return connectWithCredentials(network.ssid, network.password);  // Already connected path
     }
-    Serial.println();
     
+    connectQueue.clear();
+    connectQueue.push_back(network);
+    rememberAttempt = true;
+    startNextAttempt();
+    waitForConnect();
+    return isConnected();
+}
+
+// Blocking: connect with explicit credentials (new network from the UI)
+bool WiFiManager::connectWithCredentials(const String& ssid, const String& password) {
+    if (connectPhase != CONNECT_IDLE) {
+        waitForConnect();  // Let a background attempt finish first
+    }
     if (WiFi.status() == WL_CONNECTED) {
+        Serial.println("[WiFi] Already connected");
         state = WIFI_CONNECTED;
-        Serial.println("[WiFi] Connected!");
-        Serial.println("[WiFi] IP: " + WiFi.localIP().toString());
-        Serial.println("[WiFi] RSSI: " + String(WiFi.RSSI()) + " dBm");
-        
-        // Sync NTP time after successful connection
-        syncNTPTime();
-        
+        if (lastNTPSync == 0) {
+            syncNTPTime();
+        }
         return true;
     }
     
-    state = WIFI_FAILED;
-    Serial.println("[WiFi] Connection failed");
-    return false;
+    SavedNetwork network;
+    network.ssid = ssid;
+    network.password = password;
+    connectQueue.clear();
+    connectQueue.push_back(network);
+    rememberAttempt = false;
+    startNextAttempt();
+    waitForConnect();
+    return isConnected();
+}
+
+String WiFiManager::getProgressText() {
+    if (scanInProgress) {
+        return "Scanning...";
+    }
+    if (connectPhase != CONNECT_IDLE) {
+        return "Connecting to " + currentAttempt.ssid + "...";
+    }
+    if (ntpSyncing) {
+        return "Syncing time...";
+    }
+    return "";
 }
 
 void WiFiManager::disconnect() {
+    connectQueue.clear();
+    connectPhase = CONNECT_IDLE;
+    connectAfterScan = false;
+    ntpSyncing = false;
     WiFi.disconnect(true);
     state = WIFI_DISCONNECTED;
     Serial.println("[WiFi] Disconnected");
@@ -377,30 +710,60 @@ String WiFiManager::getStatusString() {
 }
 
 void WiFiManager::update() {
+    // Advance any in-flight connect or NTP sync - never blocks
+    if (connectPhase != CONNECT_IDLE) {
+        advanceConnect();
+    }
+    if (ntpSyncing) {
+        advanceNTPSync();
+    }
+    if (scanInProgress) {
+        updateScan();
+    }
+    
     updateState();
     
     // Auto-reconnect if enabled and disconnected
-    if (autoReconnect && state != WIFI_CONNECTED && state != WIFI_CONNECTING) {
+    if (autoReconnect && connectPhase == CONNECT_IDLE && !scanInProgress && state != WIFI_CONNECTED) {
         if (millis() - lastReconnectAttempt > reconnectInterval) {
             lastReconnectAttempt = millis();
             Serial.println("[WiFi] Auto-reconnecting...");
-            connect();
+            
+            // Several saved networks and no recent scan: find out which are in range first
+            if (savedNetworks.size() > 1 && !hasFreshScan() && startScan()) {
+                connectAfterScan = true;
+            } else {
+                beginConnect();
+            }
         }
     }
     
     // Periodic NTP sync (every 24 hours)
-    if (state == WIFI_CONNECTED && lastNTPSync > 0) {
+    if (state == WIFI_CONNECTED && lastNTPSync > 0 && !ntpSyncing) {
         unsigned long timeSinceLastSync = millis() - lastNTPSync;
         const unsigned long SYNC_INTERVAL = 24UL * 60UL * 60UL * 1000UL;  // 24 hours in ms
         
         if (timeSinceLastSync > SYNC_INTERVAL) {
             Serial.println("[WiFi] 24 hour NTP re-sync");
-            syncNTPTime();
+            beginNTPSync();
         }
     }
 }
 
 void WiFiManager::updateState() {
+    if (connectPhase != CONNECT_IDLE) return;  // advanceConnect() owns the state
+    
+    if (linkLost) {
+        linkLost = false;
+        if (state == WIFI_CONNECTED && WiFi.status() != WL_CONNECTED) {
+            // Dropped (roamed out of range) - reconnect now instead of waiting out the interval
+            state = WIFI_DISCONNECTED;
+            lastReconnectAttempt = millis() - reconnectInterval - 1;
+            Serial.println("[WiFi] Connection lost");
+            return;
+        }
+    }
+    
     if (WiFi.status() == WL_CONNECTED && state != WIFI_CONNECTED) {
         state = WIFI_CONNECTED;
         Serial.println("[WiFi] Connection established");
@@ -427,43 +790,59 @@ void WiFiManager::configureNTP() {
     Serial.println("[WiFi] NTP configured");
 }
 
+// Blocking wrapper - waits for the background sync to finish
 bool WiFiManager::syncNTPTime() {
+    unsigned long previousSync = lastNTPSync;
+    beginNTPSync();
+    while (ntpSyncing) {
+        advanceNTPSync();
+        delay(100);
+    }
+    return lastNTPSync != previousSync;
+}
+
+void WiFiManager::beginNTPSync() {
     if (!isConnected()) {
         Serial.println("[WiFi] Cannot sync NTP - not connected");
-        return false;
+        return;
     }
+    if (ntpSyncing) return;
     
     Serial.println("[WiFi] Syncing NTP time...");
     configureNTP();
-    
-    // Wait for time to be set (with timeout)
-    int attempts = 0;
-    const int MAX_ATTEMPTS = 20;  // 10 seconds total
-    
-    while (attempts < MAX_ATTEMPTS) {
-        time_t now = time(nullptr);
-        if (now > 1000000000) {  // Valid Unix timestamp (after year 2001)
-            // Calculate offset between millis() and Unix time
-            unsigned long currentMillis = millis();
-            timeOffset = now - (currentMillis / 1000);
-            lastNTPSync = currentMillis;
-            
-            // Convert to readable time for logging
-            struct tm timeinfo;
-            gmtime_r(&now, &timeinfo);
-            char timeStr[64];
-            strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S UTC", &timeinfo);
-            
-            Serial.println("[WiFi] NTP sync successful: " + String(timeStr));
-            Serial.println("[WiFi] Time offset: " + String(timeOffset) + " seconds");
-            return true;
+    ntpSyncing = true;
+    ntpStart = millis();
+}
+
+void WiFiManager::advanceNTPSync() {
+    time_t now = time(nullptr);
+    if (now > 1000000000) {  // Valid Unix timestamp (after year 2001)
+        // Calculate offset between millis() and Unix time
+        unsigned long currentMillis = millis();
+        timeOffset = now - (currentMillis / 1000);
+        lastNTPSync = currentMillis;
+        ntpSyncing = false;
+        
+        if (leaseStampPending) {
+            fastPrefs.putUInt("leased", (uint32_t)(now - (currentMillis - leaseAcquiredMs) / 1000));
+            leaseStampPending = false;
         }
-        delay(500);
-        attempts++;
+        
+        // Convert to readable time for logging
+        struct tm timeinfo;
+        gmtime_r(&now, &timeinfo);
+        char timeStr[64];
+        strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S UTC", &timeinfo);
+        
+        Serial.println("[WiFi] NTP sync successful: " + String(timeStr));
+        Serial.println("[WiFi] Time offset: " + String(timeOffset) + " seconds");
+        return;
     }
     
-    Serial.println("[WiFi] NTP sync timeout");
-    return false;
+    if (millis() - ntpStart > NTP_TIMEOUT) {
+        ntpSyncing = false;
+        Serial.println("[WiFi] NTP sync timeout");
+    }
 }
 
 unsigned long WiFiManager::getLastNTPSync() const {
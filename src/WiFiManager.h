@@ -5,6 +5,7 @@
 #include <WiFi.h>
 #include <Preferences.h>
 #include <time.h>
+#include <climits>
 #include <vector>
 
 enum WiFiConnectionState {
@@ -46,14 +47,26 @@ public:
     void clearCredentials();
     String getSavedSSID();
     
-    // Network scanning
-    std::vector<ScannedNetwork> scanNetworks();
+    // Network scanning - results are cached; startScan() refreshes them in the background
+    std::vector<ScannedNetwork> scanNetworks();  // Blocking
+    bool startScan();
+    bool isScanning() const { return scanInProgress; }
+    std::vector<ScannedNetwork> getScanResults();  // Last completed scan
+    uint32_t getScanGeneration() const { return scanGeneration; }  // Bumped on each completed scan
+    unsigned long getScanAge() const { return lastScanTime > 0 ? millis() - lastScanTime : ULONG_MAX; }
+    bool hasFreshScan() const;
     int getScannedNetworkCount();
     
     // Connection management (now with waterfall support)
+    // Blocking calls wait on the state machine below - for UI flows that need the result
     bool connect();  // Try to connect to any saved network (waterfall)
     bool connectToNetwork(const String& ssid);  // Connect to specific saved network
     bool connectWithCredentials(const String& ssid, const String& password);
+    
+    // Non-blocking connect - returns immediately, update() advances it
+    void beginConnect();
+    bool isConnecting() const { return connectPhase != CONNECT_IDLE; }
+    String getProgressText();  // "Connecting to X..." / "Syncing time..." / "" when idle
     void disconnect();
     bool isConnected();
     String getConnectedSSID();
@@ -72,22 +85,59 @@ public:
     void setReconnectInterval(unsigned long intervalMs);
     
     // Time synchronization
-    bool syncNTPTime();
+    bool syncNTPTime();  // Blocking
+    void beginNTPSync();  // Non-blocking, advanced by update()
+    bool isNTPSyncing() const { return ntpSyncing; }
     unsigned long getLastNTPSync() const;
     long getTimeOffset() const;
 
 private:
+    // Connection state machine - one attempt in flight, the rest of the waterfall queued
+    enum ConnectPhase {
+        CONNECT_IDLE,
+        CONNECT_CACHED,   // Directed connect to the cached AP
+        CONNECT_NETWORK   // Normal connect to a queued network
+    };
+    
     void configureNTP();
+    void advanceNTPSync();
     bool connectToSavedNetwork(const SavedNetwork& network);
     void saveLastConnectedSSID(const String& ssid);
     String getLastConnectedSSID();
     
+    bool startCachedAttempt();
+    void startNextAttempt();
+    void advanceConnect();
+    void finishConnect();
+    void waitForConnect();
+    void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info);  // WiFi event task
+    
+    ConnectPhase connectPhase;
+    std::vector<SavedNetwork> connectQueue;  // Waterfall candidates not yet tried
+    SavedNetwork currentAttempt;
+    unsigned long attemptStart;
+    volatile bool attemptFailed;  // Driver reported a hard failure (no AP, bad password)
+    volatile bool linkLost;       // Disconnect event since last update()
+    bool attemptUsesLease;
+    bool leaseStampPending;       // Lease cached before NTP - its start time is set once synced
+    unsigned long leaseAcquiredMs;
+    bool rememberAttempt;         // Save as last connected SSID on success
+    bool eventsRegistered;
+    uint8_t cachedBSSID[6];
+    
+    // Fast reconnect cache - AP, channel and DHCP lease of the last good connection.
+    // Kept in its own namespace because saveSavedNetworks() clears "wifi". Only written
+    // when a DHCP connect refreshes it, never on a plain reuse.
+    void saveFastConnectCache();
+    void clearFastConnectCache();
+    bool cachedLeaseFresh();
+    
     Preferences prefs;
+    Preferences fastPrefs;
     WiFiConnectionState state;
     bool autoReconnect;
     unsigned long lastReconnectAttempt;
     unsigned long reconnectInterval;
-    int connectionAttempts;
     
     // Multi-network storage
     std::vector<SavedNetwork> savedNetworks;
@@ -95,12 +145,27 @@ private:
     void loadSavedNetworks();
     void saveSavedNetworks();
     
+    // Background scan state
+    bool scanInProgress;
+    bool connectAfterScan;        // beginConnect() deferred until the scan finishes
+    unsigned long lastScanTime;   // millis() of last completed scan (0 = never)
+    uint32_t scanGeneration;
+    void updateScan();
+    void collectScanResults(int n);
+    int getScannedRSSI(const String& ssid) const;
+    
     // Time tracking
     unsigned long lastNTPSync;  // millis() when last NTP sync occurred
     long timeOffset;  // Offset to add to millis() to get Unix timestamp
+    bool ntpSyncing;
+    unsigned long ntpStart;
     
-    static const int MAX_CONNECTION_ATTEMPTS = 3;
     static const unsigned long CONNECTION_TIMEOUT = 10000; // 10 seconds
+    static const unsigned long NTP_TIMEOUT = 10000; // 10 seconds
+    static const unsigned long SCAN_CACHE_MAX_AGE = 300000; // Trust a scan for 5 minutes
+    static const unsigned long FAST_CONNECT_TIMEOUT = 4000; // Known AP + channel, no scan
+    static const uint32_t FAST_LEASE_DEFAULT_S = 3600;  // Lease length assumed when the server's is unknown
+    static const time_t CLOCK_VALID_AFTER = 1000000000; // time() below this = not synced yet
     static const int MAX_SAVED_NETWORKS = 10;  // Limit to prevent memory issues
     
     void updateState();
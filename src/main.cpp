@@ -12,6 +12,9 @@
 #include "Logger.h"
 #include "WiFiManager.h"
 #include "OTAUpdater.h"
+#include "ConversationIndex.h"
+#include "Metrics.h"
+#include "Scheduler.h"
 
 // Pin definitions for Heltec Vision Master E290
 #define I2C_SDA 39
@@ -85,23 +88,20 @@ String tempVillageName = "";  // Temp storage during village creation
 String tempWiFiSSID = "";     // Temp storage during WiFi setup
 String tempWiFiPassword = ""; // Temp storage during WiFi setup
 
-// Conversation list tracking
-struct ConversationEntry {
-  int slot;
-  String name;
-  String id;
-  unsigned long lastActivity;  // Timestamp of most recent message
-};
+// Conversation list tracking (ConversationEntry lives in ConversationIndex.h)
 std::vector<ConversationEntry> conversationList;
 
-// Helper function to delay while still polling keyboard frequently
+// Pause inside a handler while keyboard and MQTT keep being serviced.
+// Blocks between their runs instead of spinning (see Scheduler::delay)
 void smartDelay(unsigned long ms) {
-  unsigned long start = millis();
-  while (millis() - start < ms) {
-    keyboard.update();  // Poll keyboard every 10ms instead of continuously
-    mqttMessenger.loop();  // Process MQTT messages during delays
-    yield();  // Let ESP32 handle background tasks
-    delay(10);  // Add delay to prevent 880k+ polling spam
+  scheduler.delay(ms);
+}
+
+// Show-a-message-and-wait screens: block until ENTER is pressed
+void waitForEnter() {
+  while (!keyboard.isEnterPressed()) {
+    keyboard.dropSpecialKey();
+    smartDelay(50);
   }
 }
 
@@ -113,28 +113,45 @@ const unsigned long MESSAGING_TIMEOUT = 300000;  // 5 minutes timeout
 int currentVillageSlot = -1;  // Track which village slot is currently active (-1 = none)
 bool isSyncing = false;  // Flag to track if we're currently syncing (skip status updates during sync)
 
-// Build conversation list from valid villages, sorted by most recent activity
-void buildConversationList() {
-  conversationList.clear();
+const int MAX_MESSAGES_TO_LOAD = 30;  // Only load most recent 30 messages
+
+// Page loader for the UI history window - returns up to count stored messages of the current
+// village right before (older) or after the given one, oldest first. Called when the user
+// scrolls past the loaded window.
+std::vector<Message> loadHistoryPage(unsigned long timestamp, uint32_t storeOffset, int count, bool older) {
+  if (!village.isInitialized() || count <= 0) {
+    return std::vector<Message>();
+  }
+  // Seeks via the message index
+  return older ? village.loadMessagesBefore(timestamp, storeOffset, count)
+               : village.loadMessagesAfter(timestamp, storeOffset, count);
+}
+
+// Load the newest MAX_MESSAGES_TO_LOAD messages of the current village into the UI.
+// Older history is paged in on demand as the user scrolls. Returns total stored count.
+int loadRecentMessagesIntoUI() {
+  ui.clearMessages();
   
-  // Scan all 10 slots for valid villages
-  for (int i = 0; i < 10; i++) {
-    if (Village::hasVillageInSlot(i)) {
-      ConversationEntry entry;
-      entry.slot = i;
-      entry.name = Village::getVillageNameFromSlot(i);
-      entry.id = Village::getVillageIdFromSlot(i);
-      entry.lastActivity = 0;  // TODO: get from most recent message timestamp
-      conversationList.push_back(entry);
-    }
+  int total = village.getStoredMessageCount();
+  int startIndex = total > MAX_MESSAGES_TO_LOAD ? total - MAX_MESSAGES_TO_LOAD : 0;
+  std::vector<Message> messages = village.loadMessageRange(startIndex, total - startIndex);
+  for (const Message& msg : messages) {
+    ui.addMessage(msg);
   }
+  conversationIndex.setViewing(village.getVillageId());  // Clears its unread count
   
-  // Sort by most recent activity (for now, just keep discovery order)
-  // TODO: Sort by lastActivity timestamp once we track message times
+  Serial.println("[App] Displaying last " + String(messages.size()) + " of " + String(total) + " messages");
+  return total;
+}
+
+// Build conversation list from valid villages, sorted by most recent activity
+void buildConversationList() {
+  // Served from the conversation manifest (already sorted by last activity)
+  conversationList = conversationIndex.getConversations();
   
   Serial.println("[Conversations] Found " + String(conversationList.size()) + " valid villages");
   for (const auto& conv : conversationList) {
-    Serial.println("  Slot " + String(conv.slot) + ": " + conv.name);
+    Serial.println("  Slot " + String(conv.slot) + ": " + conv.name + " (unread " + String(conv.unreadCount) + ")");
   }
 }
 
@@ -156,7 +173,7 @@ float sleepBatteryVoltage = 0.0;  // Battery voltage when entering nap mode
 bool isUsbPowered() {
   // ESP32-S3 can detect USB power via battery voltage
   // When USB connected, battery reads higher voltage (charging)
-  float voltage = battery.getVoltage();
+  float voltage = battery.getSampleVoltage();  // Unsmoothed - plugging in shows within one sample
   return (voltage > 4.1);  // USB charging shows ~4.14-4.15V (lowered from 4.3V)
 }
 
@@ -299,7 +316,6 @@ bool isUserTyping() {
   return (millis() - lastKeystroke) < TYPING_TIMEOUT;
 }
 
-const int MAX_MESSAGES_TO_LOAD = 30;  // Only load most recent 30 messages
 unsigned long lastOTACheck = 0;  // Track automatic OTA update checks
 unsigned long lastPeriodicSync = 0;  // Track periodic background sync
 const unsigned long PERIODIC_SYNC_INTERVAL = 30000;  // Sync every 30 seconds when active
@@ -333,6 +349,63 @@ unsigned long getCurrentTime() {
   return 1765324800 + (millis() / 1000);
 }
 
+// ===== Nap state in RTC slow memory =====
+// Survives deep sleep (cleared by power cycle or reset), so a timer wake can check for
+// messages without re-running the full boot: no display, keyboard, OTA or message load.
+#define NAP_STATE_MAGIC 0x534D4F4C  // "SMOL"
+const unsigned long NAP_MQTT_CONNECT_TIMEOUT = 5000;  // Give up on the broker after 5s
+const unsigned long NAP_LISTEN_WINDOW = 3000;         // Listen for queued/synced messages
+#define NAP_SEEN_IDS 32  // Recently stored message IDs remembered across naps
+#define NAP_ID_LEN 20    // Generated IDs are 16 hex chars
+
+struct NapState {
+  uint32_t magic;
+  int8_t villageSlot;                          // Active village, restored on full wake
+  unsigned long highWater[MAX_VILLAGE_SLOTS];  // Newest stored message timestamp per slot
+  uint32_t quietNaps;                          // Consecutive fast wakes with nothing new
+  char seenIds[NAP_SEEN_IDS][NAP_ID_LEN];      // Ring of recently stored message IDs
+  uint8_t seenNext;
+};
+
+RTC_DATA_ATTR NapState napState;
+int napNewMessages = 0;  // Messages stored during this fast wake
+
+bool napIdSeen(const String& messageId) {
+  for (int i = 0; i < NAP_SEEN_IDS; i++) {
+    if (messageId == napState.seenIds[i]) return true;
+  }
+  return false;
+}
+
+void rememberNapId(const String& messageId) {
+  if (messageId.isEmpty() || napIdSeen(messageId)) return;
+  strncpy(napState.seenIds[napState.seenNext], messageId.c_str(), NAP_ID_LEN - 1);
+  napState.seenIds[napState.seenNext][NAP_ID_LEN - 1] = '\0';
+  napState.seenNext = (napState.seenNext + 1) % NAP_SEEN_IDS;
+}
+
+void saveNapState() {
+  if (napState.magic != NAP_STATE_MAGIC) {
+    // Left over from an earlier nap cycle - start the ring clean
+    memset(napState.seenIds, 0, sizeof(napState.seenIds));
+    napState.seenNext = 0;
+  }
+  napState.magic = NAP_STATE_MAGIC;
+  napState.villageSlot = currentVillageSlot;
+  for (int i = 0; i < MAX_VILLAGE_SLOTS; i++) {
+    napState.highWater[i] = conversationIndex.getLastActivity(i);
+  }
+}
+
+void configureNapWakeSources() {
+  // Wake on timer (15 minutes)
+  esp_sleep_enable_timer_wakeup(NAP_WAKE_INTERVAL * 1000ULL);  // Convert ms to microseconds
+  
+  // Wake on keyboard interrupt (GPIO 39 = I2C SDA / CardKB INT)
+  // CardKB pulls line LOW when any key is pressed
+  esp_sleep_enable_ext0_wakeup((gpio_num_t)KEYBOARD_INT_PIN, 0);
+}
+
 // Power management - graceful shutdown
 void enterDeepSleep() {
   Serial.println("[Power] Entering deep sleep mode (mode=" + String(powerMode) + ")");
@@ -353,6 +426,8 @@ void enterDeepSleep() {
     smartDelay(3000);
     
     Serial.println("[Power] Entering permanent sleep - charge to wake");
+    conversationIndex.flush();
+    logger.flush();  // Drain the async log queue to Serial and flash
     Serial.flush();
     
     // No wake sources - only power cycle/reset will wake
@@ -386,17 +461,18 @@ void enterDeepSleep() {
   
   // Configure wake sources for napping mode
   if (powerMode == POWER_NAPPING) {
-    // Wake on timer (15 minutes)
-    esp_sleep_enable_timer_wakeup(NAP_WAKE_INTERVAL * 1000ULL);  // Convert ms to microseconds
+    configureNapWakeSources();
     Serial.println("[Power] Timer wake enabled: 15 minutes");
-    
-    // Wake on keyboard interrupt (GPIO 39 = I2C SDA / CardKB INT)
-    // CardKB pulls line LOW when any key is pressed
-    esp_sleep_enable_ext0_wakeup((gpio_num_t)KEYBOARD_INT_PIN, 0);
     Serial.println("[Power] Keyboard wake enabled: GPIO 39 (any key press)");
+    
+    // Remember village, high-water marks and AP so the timer wake can take the fast path
+    saveNapState();
+    napState.quietNaps = 0;
   }
   
   Serial.println("[Power] Entering deep sleep now");
+  conversationIndex.flush();
+  logger.flush();  // Drain the async log queue to Serial and flash
   Serial.flush();
   
   // Enter deep sleep
@@ -405,7 +481,217 @@ void enterDeepSleep() {
   // Device will restart from setup() when it wakes
 }
 
+// Message callback used only during a fast nap wake - store anything not stored yet, no UI.
+// Deduplicated by message ID only: the broker already PUBACKed these, so a message that
+// is older than the high-water mark (sender clock behind, out-of-order redelivery after a
+// resumed session) must still be kept
+void onNapMessageReceived(const Message& msg) {
+  int slot = Village::findVillageSlotById(msg.villageId);
+  if (slot < 0) return;
+  
+  if (napIdSeen(msg.messageId)) return;
+  bool activeVillage = village.isInitialized() && msg.villageId == String(village.getVillageId());
+  if (activeVillage && village.messageIdExists(msg.messageId)) return;
+  
+  if (Village::saveMessageToFile(msg)) {
+    rememberNapId(msg.messageId);
+    napNewMessages++;
+    Serial.println("[Power] Nap: new message in slot " + String(slot) + " from " + msg.sender);
+  }
+}
+
+void sleepUntilNextNap() {
+  conversationIndex.flush();
+  saveNapState();
+  Serial.println("[Power] Nap: nothing to show - back to sleep after " + String(millis()) + "ms awake");
+  Serial.flush();
+  
+  configureNapWakeSources();
+  esp_deep_sleep_start();
+}
+
+// Minimal connect-check-sleep cycle for timer wakes. Only brings up WiFi and MQTT.
+// Never returns if nothing new arrived; returns true if the full boot should show messages.
+bool runFastWakeCycle() {
+  Serial.println("[Power] Nap fast wake (quiet naps: " + String(napState.quietNaps) + ")");
+  
+  // Low battery: let the full boot path show the warning and sleep for good
+  battery.begin();
+  if (battery.getVoltage() < LOW_BATTERY_THRESHOLD) {
+    return false;
+  }
+  
+  Village::loadSlotRegistry();
+  conversationIndex.begin();
+  
+  // connect() tries the cached AP/channel/lease first and only scans if that fails
+  wifiManager.begin();
+  if (!wifiManager.connect()) {
+    napState.quietNaps++;
+    sleepUntilNextNap();
+  }
+  
+  // Active village provides the key and topic for the sync request
+  if (napState.villageSlot >= 0 && village.loadFromSlot(napState.villageSlot)) {
+    encryption.setKey(village.getEncryptionKey());
+    mqttMessenger.setActiveVillage(village.getVillageId());
+  }
+  
+  mqttMessenger.setEncryption(&encryption);
+  mqttMessenger.setMessageCallback(onNapMessageReceived);
+  if (mqttMessenger.begin()) {
+    mqttMessenger.subscribeToAllVillages();
+    
+    unsigned long start = millis();
+    while (!mqttMessenger.isConnected() && millis() - start < NAP_MQTT_CONNECT_TIMEOUT) {
+      delay(50);
+    }
+    
+    if (mqttMessenger.isConnected()) {
+      // Resumed session: the broker flushes what it queued while we slept, no sync needed
+      if (village.isInitialized() && !mqttMessenger.hasSessionPresent()) {
+        // A sync replays history we already have - dedup it against the stored IDs
+        village.rebuildMessageIdCache();
+        mqttMessenger.requestSync(napState.highWater[napState.villageSlot]);
+      }
+      
+      start = millis();
+      while (millis() - start < NAP_LISTEN_WINDOW) {
+        mqttMessenger.loop();
+        delay(20);
+      }
+    }
+  }
+  
+  if (napNewMessages == 0) {
+    napState.quietNaps++;
+    sleepUntilNextNap();
+  }
+  
+  Serial.println("[Power] Nap: " + String(napNewMessages) + " new messages - waking fully");
+  napState.quietNaps = 0;
+  return true;
+}
+
+// ===== Boot sequence =====
+// setup() only brings up what the first interactive frame needs (logger, display,
+// keyboard, battery). Everything else is a deferred stage run from loop(), one per
+// pass, so keys are serviced between stages. Each stage is timed and logged.
+#define MAX_BOOT_MARKS 16
+
+struct BootMark {
+  const char* name;
+  unsigned long ms;  // Duration of the stage
+};
+
+BootMark bootMarks[MAX_BOOT_MARKS];
+int bootMarkCount = 0;
+unsigned long lastBootMark = 0;
+int deferredBootStage = 0;  // Next deferred stage to run
+bool bootComplete = false;
+int taskBoot = -1;          // Scheduler task running the deferred stages
+
+void bootMark(const char* name) {
+  unsigned long now = millis();
+  if (bootMarkCount < MAX_BOOT_MARKS) {
+    bootMarks[bootMarkCount++] = { name, now - lastBootMark };
+  }
+  Serial.println("[Boot] " + String(name) + ": " + String(now - lastBootMark) + "ms (t=" + String(now) + "ms)");
+  lastBootMark = now;
+}
+
+void logBootSummary() {
+  String summary = "Boot:";
+  for (int i = 0; i < bootMarkCount; i++) {
+    summary += " " + String(bootMarks[i].name) + "=" + String(bootMarks[i].ms);
+  }
+  summary += " interactive=" + String(metrics.getGauge(GAUGE_BOOT_INTERACTIVE_MS));
+  summary += " ready=" + String(metrics.getGauge(GAUGE_BOOT_READY_MS));
+  logger.info(summary);
+}
+
+// ===== Network bring-up =====
+// WiFi connects in the background (WiFiManager state machine), so everything that needs
+// the network is started from loop() when it comes up instead of blocking setup().
+const unsigned long BOOT_SYNC_DELAY = 2000;  // Let MQTT subscriptions settle before syncing
+bool bootSyncDone = false;
+bool bootUpdateCheckDone = false;
+unsigned long mqttReadySince = 0;
+
+void checkForUpdateOnBoot() {
+  Serial.println("[OTA] Checking for updates on boot...");
+  logger.info("OTA: Boot update check");
+  if (otaUpdater.checkForUpdate()) {
+    logger.info("OTA: New version available: " + otaUpdater.getLatestVersion());
+    // Show update screen and let user decide
+    appState = APP_OTA_CHECKING;
+    ui.setState(STATE_OTA_CHECK);
+    String updateInfo = "Update Available\n\n";
+    updateInfo += "New: " + otaUpdater.getLatestVersion() + "\n";
+    updateInfo += "Current: " + otaUpdater.getCurrentVersion() + "\n\n";
+    updateInfo += "Press RIGHT to update\nPress LEFT to skip";
+    ui.setInputText(updateInfo);
+    ui.updateFull();
+    Serial.println("[System] Showing update screen");
+  }
+}
+
+// Called once each time WiFi (and its NTP sync) becomes ready
+void onNetworkReady() {
+  Serial.println("[WiFi] Connected: " + wifiManager.getIPAddress());
+  logger.info("WiFi connected: " + wifiManager.getIPAddress());
+  
+  // Initialize MQTT messenger after WiFi connects (no-op if already running)
+  Serial.println("[MQTT] Initializing MQTT messenger...");
+  if (mqttMessenger.begin()) {
+    Serial.println("[MQTT] MQTT messenger ready");
+    logger.info("MQTT messenger initialized");
+    
+    // Subscribe to all saved villages for multi-village support
+    mqttMessenger.subscribeToAllVillages();
+    Serial.println("[MQTT] Subscribed to all saved villages");
+  } else {
+    Serial.println("[MQTT] Failed to initialize");
+  }
+  
+  // Check for OTA updates on first connect after boot - only from the menu, never mid-task
+  if (!bootUpdateCheckDone) {
+    bootUpdateCheckDone = true;
+    if (appState == APP_MAIN_MENU) {
+      checkForUpdateOnBoot();
+    }
+  }
+}
+
+// Poll from loop(): network bring-up, one-time boot sync and header status
+void serviceNetwork() {
+  static bool networkReady = false;
+  // MQTT delivers into the village store - wait for the deferred village stage
+  bool ready = bootComplete && wifiManager.isConnected() && !wifiManager.isNTPSyncing();
+  if (ready && !networkReady) {
+    onNetworkReady();
+  }
+  networkReady = ready;
+  
+  // Request message sync once MQTT is up (in case we missed messages while offline).
+  // Not needed when the broker resumed our persistent session - it already delivered the backlog.
+  if (!bootSyncDone && mqttMessenger.isConnected()) {
+    if (mqttReadySince == 0) {
+      mqttReadySince = millis();
+    } else if (millis() - mqttReadySince >= BOOT_SYNC_DELAY) {
+      bootSyncDone = true;
+      if (!mqttMessenger.hasSessionPresent()) {
+        Serial.println("[Sync] Requesting sync from peers");
+        mqttMessenger.requestSync(0);  // Request all messages, will deduplicate locally
+      }
+    }
+  }
+  
+  ui.setStatusText(wifiManager.getProgressText());
+}
+
 // Forward declarations
+void registerTasks();
 void handleMainMenu();
 void handleConversationList();
 void handleSettingsMenu();
@@ -437,58 +723,22 @@ void handleViewMembers();
 void handleMessaging();
 void handleMessageCompose();
 void dumpMessageStoreDebug(int completedPhase);
+void publishDeviceStats();
+
+// Someone joined while the invite code was showing. The ENTER prompt needs the keyboard,
+// which only the loop task may read, so the callback just leaves the name here for
+// handleInviteCodeDisplay()
+volatile bool joinerPending = false;
+String joinerName;
 
 // Message callback
 void onMessageReceived(const Message& msg) {
-  Serial.println("[Message] From " + msg.sender + ": " + msg.content + " (village: " + msg.villageId + ")");
+  LOG_TRACE("Message", "From %s: %s (village: %s)", msg.sender.c_str(), msg.content.c_str(), msg.villageId.c_str());
   
   // Reset activity timer - new message keeps device awake
   lastActivityTime = millis();
   Serial.println("[Power] Activity timer reset - message received");
   
-  // AUTO-TRANSITION: If creator is on invite screen and someone joins, DON'T auto-transition
-  // Let them manually proceed so the joiner has time to see/share the code
-  if (appState == APP_INVITE_CODE_DISPLAY && msg.content.endsWith(" joined the conversation")) {
-    Serial.println("[Invite] New member joined - showing success message instead of auto-transitioning");
-    String code = ui.getInviteCode();
-    ui.clearInviteCode();
-    // Unpublish invite
-    if (!code.isEmpty()) {
-      mqttMessenger.unsubscribeFromInvite(code);
-      mqttMessenger.unpublishInvite(code);
-    }
-    
-    // Show success message and wait for user to proceed
-    ui.showMessage("Success!", msg.sender + " joined!\n\nPress ENTER\nto continue", 0);
-    keyboard.clearInput();
-    while (!keyboard.isEnterPressed()) { 
-      keyboard.update(); 
-      smartDelay(50); 
-    }
-    keyboard.clearInput();
-    
-    // FIXED: Properly initialize messaging screen (same as normal entry path)
-    ui.setInputText("");  // Clear any text in input field
-    ui.setCurrentUsername(village.getUsername());  // Set username for message display
-    
-    // Load messages from storage
-    ui.clearMessages();
-    std::vector<Message> messages = village.loadMessages();
-    int startIndex = messages.size() > MAX_MESSAGES_TO_LOAD ? messages.size() - MAX_MESSAGES_TO_LOAD : 0;
-    for (int i = startIndex; i < messages.size(); i++) {
-      ui.addMessage(messages[i]);
-    }
-    Serial.println("[Invite] Manual transition: Loaded " + String(messages.size() - startIndex) + " of " + String(messages.size()) + " messages");
-    
-    // Transition to messaging
-    appState = APP_MESSAGING;
-    ui.setState(STATE_MESSAGING);
-    inMessagingScreen = true;
-    lastMessagingActivity = millis();
-    // ...removed markVisibleMessagesAsRead();
-    ui.update();
-  }
-  
   // Check if this message is for the currently loaded village
   bool isForCurrentVillage = village.isInitialized() && (String(village.getVillageId()) == msg.villageId);
   
@@ -498,10 +748,8 @@ void onMessageReceived(const Message& msg) {
   // ===== SYNC DEBUG: Log every incoming message during sync =====
   int syncPhase = mqttMessenger.getCurrentSyncPhase();
   if (syncPhase > 0) {
-    Serial.println("[SYNC DEBUG] Receiving msg: ID=" + msg.messageId + 
-                   " from=" + msg.sender + 
-                   " isNew=" + String(isNewMessage ? "YES" : "NO") + 
-                   " phase=" + String(syncPhase));
+    LOG_TRACE("SYNC DEBUG", "Receiving msg: ID=%s from=%s isNew=%s phase=%d",
+              msg.messageId.c_str(), msg.sender.c_str(), isNewMessage ? "YES" : "NO", syncPhase);
   }
   
   // PRESERVE ORIGINAL TIMESTAMP - no adjustment needed now that we use NTP time
@@ -527,12 +775,14 @@ void onMessageReceived(const Message& msg) {
   // Save message - only save to active village if it matches, otherwise skip UI update
   if (isForCurrentVillage) {
     // Message is for current village - save and optionally update UI
-    village.saveMessage(msg);
+    Message shown = msg;
+    village.saveMessage(msg, &shown.storeOffset);  // Store position = the UI's paging cursor
+    rememberNapId(msg.messageId);  // A redelivery during the next nap is then skipped
     
     // Conditionally update UI
     if (shouldUpdateUI) {
-      ui.addMessage(msg);
-      Serial.println("[Message] Added to UI. Total messages in history: " + String(ui.getMessageCount()));
+      ui.postMessage(shown);  // Applied on the loop task before the next frame
+      LOG_TRACE("Message", "Posted to UI");
       // Play ringtone if: real-time message AND not viewing this conversation AND ringtone enabled
       bool isRealTime = (syncPhase == 0);
       bool notViewingConversation = !(appState == APP_MESSAGING && inMessagingScreen);
@@ -543,8 +793,8 @@ void onMessageReceived(const Message& msg) {
       Serial.println("[Message] Silently cached (not added to UI)");
       // NEW: If this is a new message (even from sync), and we're in the messaging screen, add to UI and reset scroll
       if (isNewMessage && appState == APP_MESSAGING && inMessagingScreen) {
-        ui.addMessage(msg);
-        Serial.println("[Message] [Sync] Added to UI due to active messaging screen. Total messages in history: " + String(ui.getMessageCount()));
+        ui.postMessage(shown);
+        Serial.println("[Message] [Sync] Posted to UI due to active messaging screen");
       }
     }
     
@@ -553,6 +803,7 @@ void onMessageReceived(const Message& msg) {
     // Message is for a different village - save to messages.dat without updating UI
     Serial.println("[Message] Message for different village (" + msg.villageId + ") - saving to storage only");
     Village::saveMessageToFile(msg);  // Use static method to save without loading village
+    rememberNapId(msg.messageId);
     
     // Play ringtone for messages in other conversations (if real-time and new)
     bool isRealTime = (syncPhase == 0);
@@ -565,9 +816,19 @@ void onMessageReceived(const Message& msg) {
   // AND if we're actively viewing the messaging screen AND it's for the current village
   // ...removed MSG_RECEIVED/MSG_READ status upgrade block
   
-  // Always update display when in messaging screen (even if not marked as read yet)
+  // Mark the messaging screen dirty rather than drawing here - this runs on the MQTT task
+  // and sync bursts deliver dozens of messages, so loop() coalesces them into one frame
   if (appState == APP_MESSAGING && inMessagingScreen) {
-    ui.update();  // Use full update to ensure messages appear
+    ui.requestUpdate();
+  }
+  
+  // AUTO-TRANSITION: If creator is on invite screen and someone joins, DON'T auto-transition
+  // Let them manually proceed so the joiner has time to see/share the code. Flagged after
+  // the save, so the messaging screen loaded behind the prompt already has this message
+  if (appState == APP_INVITE_CODE_DISPLAY && msg.content.endsWith(" joined the conversation")) {
+    Serial.println("[Invite] New member joined - success prompt handed to the loop task");
+    joinerName = msg.sender;
+    joinerPending = true;
   }
 }
 
@@ -583,7 +844,7 @@ void onCommandReceived(const String& command) {
     
     // Only show update screen if on main menu (not interrupting active use)
     if (appState == APP_MAIN_MENU || appState == APP_CONVERSATION_MENU) {
-      if (otaUpdater.checkForUpdate()) {
+      if (otaUpdater.checkForUpdate(true)) {  // Bypass the check interval
         logger.info("OTA: Critical update available: " + otaUpdater.getLatestVersion());
         appState = APP_OTA_CHECKING;
         ui.setState(STATE_OTA_CHECK);
@@ -602,17 +863,69 @@ void onCommandReceived(const String& command) {
   } else if (command == "reboot") {
     Serial.println("[Command] Rebooting device...");
     logger.info("Rebooting via MQTT command");
+    conversationIndex.flush();
     smartDelay(1000);
     ESP.restart();
   } else if (command == "dump") {
     Serial.println("[Command] Dumping message store state...");
     dumpMessageStoreDebug(0);  // 0 = manual dump, not sync-triggered
+  } else if (command == "stats") {
+    publishDeviceStats();
   } else {
     Serial.println("[Command] Unknown command: " + command);
     logger.error("Unknown command: " + command);
   }
 }
 
+// Reply to the "stats" command with a JSON snapshot on smoltxt/<mac>/stats, so devices
+// in the field can be profiled without a USB cable. Runs on the MQTT task - only cheap
+// reads here (file size, counters), nothing that walks the message store.
+void publishDeviceStats() {
+  metrics.refreshGauges();
+  
+  JsonDocument doc;
+  doc["ver"] = BUILD_NUMBER;
+  doc["up"] = millis() / 1000;
+  
+  JsonObject heap = doc["heap"].to<JsonObject>();
+  heap["free"] = ESP.getFreeHeap();
+  heap["min"] = ESP.getMinFreeHeap();
+  heap["block"] = ESP.getMaxAllocHeap();
+  
+  File store = LittleFS.open("/messages.dat", "r");
+  doc["store"] = store ? store.size() : 0;
+  if (store) store.close();
+  
+  JsonObject sync = doc["sync"].to<JsonObject>();
+  sync["phase"] = mqttMessenger.getCurrentSyncPhase();
+  sync["active"] = isSyncing;
+  sync["outbox"] = mqttMessenger.getOutboxSize();
+  
+  JsonObject refresh = doc["refresh"].to<JsonObject>();
+  refresh["partial"] = metrics.getCounter(CTR_DISPLAY_PARTIAL);
+  refresh["full"] = metrics.getCounter(CTR_DISPLAY_FULL);
+  
+  JsonObject wifi = doc["wifi"].to<JsonObject>();
+  wifi["rssi"] = WiFi.RSSI();
+  wifi["connects"] = metrics.getCount(HIST_WIFI_CONNECT);
+  wifi["avgMs"] = metrics.getAverage(HIST_WIFI_CONNECT) / 1000;
+  
+  // Share of time since boot (or !RESETTASKS) spent idle / explicitly light-sleeping
+  JsonObject power = doc["power"].to<JsonObject>();
+  uint32_t windowMs = scheduler.getStatsWindowMs();
+  power["idlePct"] = windowMs > 0 ? (int)(scheduler.getIdleUs() / 10 / windowMs) : 0;
+  power["sleepPct"] = windowMs > 0 ? (int)(scheduler.getLightSleepUs() / 10 / windowMs) : 0;
+  power["autoSleep"] = scheduler.isAutoLightSleep();
+  
+  metrics.toJson(doc["metrics"].to<JsonObject>());
+  
+  String payload;
+  serializeJson(doc, payload);
+  if (mqttMessenger.publishStats(payload)) {
+    logger.info("Stats published (" + String(payload.length()) + " bytes)");
+  }
+}
+
 // Debug function to dump message store state after sync phase completes
 void dumpMessageStoreDebug(int completedPhase) {
   char myMAC[13];
@@ -741,7 +1054,7 @@ void onVillageNameReceived(const String& villageId, const String& villageName) {
     if (slot == currentVillageSlot) {
       village.setVillageName(villageName);
       ui.setExistingConversationName(villageName);
-      ui.update();  // Force full update to show new name
+      ui.requestUpdate();  // Redrawn from loop() - callback runs on the MQTT task
       mqttMessenger.setVillageInfo(villageId, villageName, village.getUsername());
     }
   } else {
@@ -750,17 +1063,37 @@ void onVillageNameReceived(const String& villageId, const String& villageName) {
 }
 
 void setup() {
+  Serial.begin(115200);
+  scheduler.begin();
+  
+  // Check wake-up reason first - a timer wake with valid RTC state takes the fast path
+  // and skips the display, keyboard and the rest of the boot unless messages arrived
+  esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
+  bool wokeFromNap = (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER || wakeup_reason == ESP_SLEEP_WAKEUP_EXT0);
+  bool napHadMessages = false;
+  
+  // RTC memory also survives esp_restart() (OTA, reboot command) and panic resets - the
+  // nap state only belongs to this boot when it is a wake from our own deep sleep
+  if (!wokeFromNap && napState.magic == NAP_STATE_MAGIC) {
+    Serial.println("[Power] Not a deep-sleep wake - discarding nap state");
+    napState.magic = 0;
+  }
+  
+  if (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER && napState.magic == NAP_STATE_MAGIC) {
+    napHadMessages = runFastWakeCycle();  // Goes straight back to sleep if nothing is new
+  }
+  
   // Enable Vext power for peripherals
   pinMode(18, OUTPUT);
   digitalWrite(18, HIGH);
   smartDelay(100);
-  
-  Serial.begin(115200);
-  smartDelay(1000);
-  
-  // Check wake-up reason
-  esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
-  bool wokeFromNap = (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER || wakeup_reason == ESP_SLEEP_WAKEUP_EXT1);
+  if (isUsbPowered()) {
+    // Give a USB host a moment to attach so boot output isn't lost - not on battery
+    unsigned long serialWait = millis();
+    while (!Serial && millis() - serialWait < 1000) {
+      delay(10);
+    }
+  }
   
   if (wokeFromNap) {
     Serial.println("[Power] Woke from nap - reason: " + String(wakeup_reason == ESP_SLEEP_WAKEUP_TIMER ? "TIMER" : "KEY_PRESS"));
@@ -784,7 +1117,7 @@ void setup() {
   Serial.println("SmolTxt - Safe Texting for Kids");
   Serial.println("=================================");
   Serial.println("Boot starting...");
-  smartDelay(500);  // Give time to see messages
+  bootMark("power");
   
   // Initialize logger FIRST to capture all subsequent boot events
   Serial.println("[Logger] Initializing event logger...");
@@ -795,11 +1128,14 @@ void setup() {
   }
   logger.info("System boot started");
   logger.info("Build: " + String(BUILD_NUMBER));
-  Serial.flush();
-  smartDelay(100);
+  bootMark("logger");
   
-  Serial.flush();
-  smartDelay(100);
+  // Read slot metadata once - all slot queries are served from RAM after this
+  Village::loadSlotRegistry();
+  
+  // Load conversation manifest before MQTT can deliver messages into it
+  conversationIndex.begin();
+  bootMark("registry");
   
   // Initialize display
   Serial.println("[Display] Initializing e-paper...");
@@ -814,7 +1150,7 @@ void setup() {
   Serial.println("[Display] Showing splash...");
   ui.setState(STATE_SPLASH);
   ui.updateFull();  // Full refresh at boot for clean initial display
-  smartDelay(2000);
+  bootMark("display");
   
   // Initialize I2C for keyboard
   Serial.println("[I2C] Initializing I2C bus...");
@@ -843,11 +1179,13 @@ void setup() {
   Serial.print("[Keyboard] After clear - currentKey check: ");
   Serial.println(keyboard.isRightPressed() ? "RIGHT PRESSED!" : "no keys");
   Serial.println("[Keyboard] Buffer cleared and ready");
+  bootMark("keyboard");
   
   // Initialize messaging screen flag
   inMessagingScreen = false;
   lastMessagingActivity = 0;
-  currentVillageSlot = -1;  // No village loaded yet
+  // Restore the village we napped with (nap state was cleared above unless this is a nap wake)
+  currentVillageSlot = (napState.magic == NAP_STATE_MAGIC) ? napState.villageSlot : -1;
   
   // Initialize power management - start awake timer
   powerMode = POWER_AWAKE;
@@ -859,80 +1197,35 @@ void setup() {
   // Set typing check callback to defer display updates during typing
   ui.setTypingCheckCallback(isUserTyping);
   
+  // Older messages are paged into the UI's bounded history window on scroll
+  ui.setHistoryPageLoader(loadHistoryPage);
+  
   // Set build number for display
   ui.setBuildNumber(BUILD_NUMBER);
   
   // Initialize battery monitoring
   Serial.println("[Battery] Initializing battery monitor...");
-  battery.begin();
-  battery.update();  // Take initial reading
+  battery.begin();  // Takes the first reading, then samples in the background
   ui.setBatteryStatus(battery.getVoltage(), battery.getPercent());
   Serial.println("[Battery] Battery monitor ready");
+  bootMark("battery");
   
-  // Initialize WiFi manager
-  Serial.println("[WiFi] Initializing WiFi manager...");
-  wifiManager.begin();
-  Serial.println("[WiFi] WiFi manager ready");
-  
-  // Initialize OTA updater
-  Serial.println("[OTA] Initializing OTA updater...");
-  otaUpdater.begin(&logger);
-  otaUpdater.setGitHubRepo("zacknorman-dev", "SmallText");
-  Serial.println("[OTA] OTA updater ready");
-  
-  // Check if WiFi is configured - if so, connect
-  if (wifiManager.hasCredentials()) {
-    Serial.println("[WiFi] Found saved credentials, connecting...");
-    if (wifiManager.connect()) {
-      Serial.println("[WiFi] Connected: " + wifiManager.getIPAddress());
-      logger.info("WiFi connected: " + wifiManager.getIPAddress());
-      
-      // Initialize MQTT messenger after WiFi connects
-      Serial.println("[MQTT] Initializing MQTT messenger...");
-      if (mqttMessenger.begin()) {
-        Serial.println("[MQTT] MQTT messenger ready");
-        logger.info("MQTT messenger initialized");
-        
-        // Set up MQTT callbacks
-        mqttMessenger.setMessageCallback(onMessageReceived);
-        // ...removed setAckCallback/onMessageAcked and setReadCallback/onMessageReadReceipt
-        mqttMessenger.setCommandCallback(onCommandReceived);
-        mqttMessenger.setSyncRequestCallback(onSyncRequest);
-        mqttMessenger.setVillageNameCallback(onVillageNameReceived);
-        mqttMessenger.setInviteCallback(onInviteReceived);
-        
-        // Set encryption
-        mqttMessenger.setEncryption(&encryption);
-        
-        // Subscribe to all saved villages for multi-village support
-        mqttMessenger.subscribeToAllVillages();
-        Serial.println("[MQTT] Subscribed to all saved villages");
-      } else {
-        Serial.println("[MQTT] Failed to initialize");
-      }
-    }
-  } else {
-    Serial.println("[WiFi] No saved WiFi credentials");
-  }
-  
-  // Note: Timestamp baseline no longer needed - using NTP-synced Unix timestamps
+  // Set up MQTT callbacks before connecting - a resumed session delivers
+  // queued messages right after CONNACK
+  mqttMessenger.setMessageCallback(onMessageReceived);
+  // ...removed setAckCallback/onMessageAcked and setReadCallback/onMessageReadReceipt
+  mqttMessenger.setCommandCallback(onCommandReceived);
+  mqttMessenger.setSyncRequestCallback(onSyncRequest);
+  mqttMessenger.setVillageNameCallback(onVillageNameReceived);
+  mqttMessenger.setInviteCallback(onInviteReceived);
   
-  // Rebuild message ID cache for deduplication
-  village.rebuildMessageIdCache();
-  
-  // Request message sync if we have MQTT connection (in case we missed messages while offline)
-  if (mqttMessenger.isConnected()) {
-    Serial.println("[Sync] Waiting for MQTT subscriptions to propagate...");
-    smartDelay(2000);  // Give MQTT subscriptions time to fully activate on broker
-    Serial.println("[Sync] Requesting sync from peers");
-    mqttMessenger.requestSync(0);  // Request all messages, will deduplicate locally
-    smartDelay(1000);  // Give time for sync responses to arrive
-  }
+  // Set encryption
+  mqttMessenger.setEncryption(&encryption);
   
-  // Timer wake logic will be handled after full initialization below
+  // Note: Timestamp baseline no longer needed - using NTP-synced Unix timestamps
   
   // If woke from key press, stay awake and continue normal boot
-  if (wokeFromNap && wakeup_reason == ESP_SLEEP_WAKEUP_EXT1) {
+  if (wokeFromNap && wakeup_reason == ESP_SLEEP_WAKEUP_EXT0) {
     Serial.println("[Power] Woke by key press - staying awake");
     Serial.println("[Display] Forcing full refresh after wake from nap");
     ui.updateClean();  // Force full display refresh to prevent white screen/corruption
@@ -940,97 +1233,113 @@ void setup() {
     lastActivityTime = millis();
   }
   
-  // Check for OTA updates on boot (if WiFi connected)
-  if (wifiManager.isConnected()) {
-    Serial.println("[OTA] Checking for updates on boot...");
-    logger.info("OTA: Boot update check");
-    if (otaUpdater.checkForUpdate()) {
-      logger.info("OTA: New version available: " + otaUpdater.getLatestVersion());
-      // Show update screen and let user decide
-      appState = APP_OTA_CHECKING;
-      ui.setState(STATE_OTA_CHECK);
-      String updateInfo = "Update Available\n\n";
-      updateInfo += "New: " + otaUpdater.getLatestVersion() + "\n";
-      updateInfo += "Current: " + otaUpdater.getCurrentVersion() + "\n\n";
-      updateInfo += "Press RIGHT to update\nPress LEFT to skip";
-      ui.setInputText(updateInfo);
-      ui.updateFull();
-      Serial.println("[System] Showing update screen");
-      return; // Stay in setup, will continue in loop
-    }
-  }
-  
   // Show village select screen
   Serial.println("[System] Going to village select");
   keyboard.clearInput();  // Clear any stray keys that might trigger typing detection
   Serial.println("[System] Keyboard cleared before village select");
   
-  // Auto-load the most recently used village so MQTT is subscribed immediately
-  // This allows receiving messages even when sitting at main menu
-  if (currentVillageSlot >= 0 && Village::hasVillageInSlot(currentVillageSlot)) {
-    Serial.println("[System] Auto-loading last village from slot " + String(currentVillageSlot));
-    if (village.loadFromSlot(currentVillageSlot)) {
-      encryption.setKey(village.getEncryptionKey());
-      Serial.println("[System] Village auto-loaded: " + village.getVillageName());
-      logger.info("Auto-loaded village: " + village.getVillageName());
-      // MQTT subscription will be configured automatically in main loop
-    }
-  } else {
-    Serial.println("[System] No previous village to auto-load");
+  // Fast nap wake found new messages - stay awake and alert the user
+  if (napHadMessages) {
+    Serial.println("[Power] Woke with " + String(napNewMessages) + " new messages");
+    logger.info("Power: Nap wake with " + String(napNewMessages) + " new messages");
+    ui.updateClean();
+    playRingtone();
+    powerMode = POWER_AWAKE;
+    lastActivityTime = millis();
   }
   
-  // If woke from nap timer (not key press), check for messages then go back to sleep
-  if (wokeFromNap && wakeup_reason == ESP_SLEEP_WAKEUP_TIMER) {
-    Serial.println("[Power] Nap timer wake - checking for new messages");
-    
-    // Try to reconnect WiFi if we have credentials but not connected
-    if (wifiManager.hasCredentials() && !wifiManager.isConnected()) {
-      Serial.println("[Power] WiFi disconnected - attempting reconnect...");
-      if (wifiManager.connect()) {
-        Serial.println("[Power] WiFi reconnected: " + wifiManager.getIPAddress());
-        logger.info("WiFi auto-reconnect on wake: " + wifiManager.getIPAddress());
-        
-        // Reconnect MQTT if WiFi came back
-        if (!mqttMessenger.isConnected()) {
-          Serial.println("[Power] Reconnecting MQTT...");
-          mqttMessenger.begin();
-        }
+  // UI is live from here - network, OTA and village loading follow from loop()
+  registerTasks();
+  metrics.setGauge(GAUGE_BOOT_INTERACTIVE_MS, millis());
+  Serial.println("[Boot] Time to interactive: " + String(millis()) + "ms");
+}
+
+// Deferred boot stages, one per loop() pass. WiFi goes first - association runs in
+// the driver while the remaining stages execute.
+void serviceDeferredBoot() {
+  if (bootComplete) return;
+  
+  switch (deferredBootStage++) {
+    case 0:
+      // Start connecting in the background. MQTT, boot sync and the update
+      // check run from serviceNetwork() once it's up
+      Serial.println("[WiFi] Initializing WiFi manager...");
+      wifiManager.begin();
+      if (wifiManager.hasCredentials()) {
+        Serial.println("[WiFi] Found saved credentials, connecting in background...");
+        wifiManager.beginConnect();
       } else {
-        Serial.println("[Power] WiFi reconnect failed");
+        Serial.println("[WiFi] No saved WiFi credentials");
       }
-    }
-    
-    // Give more time for MQTT messages to arrive if WiFi is connected
-    if (mqttMessenger.isConnected()) {
-      Serial.println("[Power] Waiting for messages to arrive...");
-      for (int i = 0; i < 30; i++) {  // Wait up to 3 seconds total
-        mqttMessenger.loop();  // Process incoming messages
-        smartDelay(100);
-      }
-      Serial.println("[Power] Message wait complete");
-    }
-    
-    // Check if there are any unread messages (max 5 alerts)
-    int unreadCount = 0;
-    if (village.isInitialized()) {
-      std::vector<Message> messages = village.loadMessages();
-      for (const Message& msg : messages) {
-        // ...removed MSG_READ/MSG_SEEN status check
-          unreadCount++;
+      bootMark("wifi");
+      break;
+      
+    case 1:
+      Serial.println("[OTA] Initializing OTA updater...");
+      otaUpdater.begin(&logger);
+      otaUpdater.setGitHubRepo("zacknorman-dev", "SmallText");
+      bootMark("ota");
+      break;
+      
+    case 2:
+      // Auto-load the most recently used village so MQTT is subscribed immediately
+      // This allows receiving messages even when sitting at main menu
+      if (currentVillageSlot >= 0 && Village::hasVillageInSlot(currentVillageSlot)) {
+        Serial.println("[System] Auto-loading last village from slot " + String(currentVillageSlot));
+        if (village.loadFromSlot(currentVillageSlot)) {
+          encryption.setKey(village.getEncryptionKey());
+          Serial.println("[System] Village auto-loaded: " + village.getVillageName());
+          logger.info("Auto-loaded village: " + village.getVillageName());
+          // MQTT subscription will be configured automatically in main loop
         }
+      } else {
+        Serial.println("[System] No previous village to auto-load");
       }
-    }
+      
+      // Rebuild message ID cache for deduplication
+      village.rebuildMessageIdCache();
+      bootMark("village");
+      break;
+      
+    default:
+      bootComplete = true;
+      scheduler.setPeriod(taskBoot, 0);  // Nothing left to run
+      metrics.setGauge(GAUGE_BOOT_READY_MS, millis());
+      Serial.println("[Boot] Deferred stages done at " + String(millis()) + "ms");
+      logBootSummary();
+      break;
   }
+}
 
-  void loop() {
-  // Update logger (checks for serial connection, processes commands)
-  logger.update();
-  
-  // Update WiFi manager (handles auto-reconnection)
-  wifiManager.update();
-  
+// ===== Main loop tasks =====
+// loop() only runs the scheduler. Each subsystem that the old loop polled on every
+// pass is a task with its own rate; the deadline is how late it may start before
+// the user would notice. Stats: !TASKS over serial.
+int taskKeyboard = -1;
+int taskApp = -1;
+
+// Keyboard polling slows down once typing stops, leaving longer idle gaps - light
+// sleep with Wi-Fi down, plain blocking waits otherwise; the CardKB INT line wakes
+// the chip from light sleep for the next key.
+// With KEYBOARD_USE_INTERRUPT the task isn't polled at all - the reader task signals it
+#define KEYBOARD_ACTIVE_POLL_MS 10
+#define KEYBOARD_IDLE_POLL_MS 100
+#define KEYBOARD_IDLE_AFTER_MS 3000
+unsigned long lastKeyAt = 0;
+bool keyboardIdle = false;
+
+// Explicit light sleep powers down the radio and USB - only when neither is in use.
+// Connected and awake is the common case and is deliberately not eligible: sleeping
+// would drop the association and miss MQTT traffic (see Scheduler.h)
+bool canLightSleep() {
+  return powerMode == POWER_AWAKE && !isUsbPowered() &&
+         !wifiManager.isConnected() && !wifiManager.isConnecting() && !wifiManager.isScanning();
+}
+
+void keyboardTask() {
   // Track if user is actively typing (only if keyboard is present)
   bool hadInput = keyboard.isKeyboardPresent() ? keyboard.hasInput() : false;
+  uint32_t keysBefore = keyboard.getKeyCount();
   
   keyboard.update();
   
@@ -1041,34 +1350,34 @@ void setup() {
     // Serial.println("[Power] Activity timer reset - keyboard input");
   }
   
+  // update() handles one key per call - come back for the rest of a burst
+  if (keyboard.hasPendingKeys()) {
+    scheduler.signal(taskKeyboard);
+  }
+  
+  // Hand new keys straight to the screen handler instead of waiting for its next poll
+  if (keyboard.getKeyCount() != keysBefore) {
+    scheduler.signal(taskApp);
+    lastKeyAt = millis();
+    if (keyboardIdle) {
+      keyboardIdle = false;
+      scheduler.setPeriod(taskKeyboard, KEYBOARD_ACTIVE_POLL_MS);
+    }
+  } else if (!keyboardIdle && keyboard.isKeyboardPresent() && !keyboard.isInterruptDriven() &&
+             millis() - lastKeyAt > KEYBOARD_IDLE_AFTER_MS) {
+    keyboardIdle = true;
+    scheduler.setPeriod(taskKeyboard, KEYBOARD_IDLE_POLL_MS);
+  }
+}
+
+void powerTask() {
   // Check for messaging screen timeout (clear flag if inactive for too long)
   if (inMessagingScreen && (millis() - lastMessagingActivity > MESSAGING_TIMEOUT)) {
     Serial.println("[App] Messaging screen timeout - clearing flag");
     inMessagingScreen = false;
+    conversationIndex.setViewing("");  // New messages count as unread again
   }
   
-  // Set active village for sending messages (all villages remain subscribed for receiving)
-  static String lastActiveVillageId = "";
-  if (village.isInitialized()) {
-    String currentVillageId = village.getVillageId();
-    if (currentVillageId != lastActiveVillageId) {
-      // Village changed - set as active for sending
-      mqttMessenger.setActiveVillage(currentVillageId);
-      lastActiveVillageId = currentVillageId;
-      Serial.println("[Loop] Active village set to: " + village.getVillageName());
-    }
-  } else if (!lastActiveVillageId.isEmpty()) {
-    // Village was cleared - reset tracking
-    lastActiveVillageId = "";
-  }
-  
-  // Process incoming MQTT messages
-  mqttMessenger.loop();
-  
-  // Update battery readings (rate-limited internally)
-  battery.update();
-  ui.setBatteryStatus(battery.getVoltage(), battery.getPercent());
-  
   // Check for shutdown using Tab key held for 3 seconds
   // Tab key is 0x09 - simple and rarely used in normal operation
   bool tabCurrentlyHeld = keyboard.isTabHeld();
@@ -1109,40 +1418,79 @@ void setup() {
     }
   }
   
+  // Check for inactivity timeout - enter napping mode after 5 minutes
+  // BUT: Skip sleep if USB powered (for debugging and real-time updates)
+  if (powerMode == POWER_AWAKE && !isUsbPowered()) {
+    unsigned long inactiveTime = millis() - lastActivityTime;
+    if (inactiveTime >= AWAKE_TIMEOUT) {
+      Serial.println("[Power] 5 minutes of inactivity - entering napping mode");
+      logger.info("Power: Entering nap mode after inactivity");
+      powerMode = POWER_NAPPING;
+      sleepBatteryVoltage = battery.getVoltage();
+      enterDeepSleep();
+      // Never returns - device enters deep sleep
+    }
+  }
+}
 
-  
+void networkTask() {
+  // Advances connect/NTP state machines, auto-reconnection, then network bring-up
+  wifiManager.update();
+  serviceNetwork();
+}
+
+void mqttTask() {
+  // Sync phase continuation and dedup housekeeping (delivery runs in the ESP-MQTT task)
+  mqttMessenger.loop();
+}
+
+void batteryTask() {
+  battery.update();
+  ui.setBatteryStatus(battery.getVoltage(), battery.getPercent());
+}
+
+void syncTask() {
   // Periodic background sync - request messages from all villages every 30 seconds
   // Skip if in APP_MESSAGING state (conversation list or viewing messages)
   if (village.isInitialized() && appState != APP_MESSAGING && (millis() - lastPeriodicSync >= PERIODIC_SYNC_INTERVAL)) {
     Serial.println("[App] Periodic sync check");
     
-    // Get timestamp of most recent message for sync optimization
-    std::vector<Message> messages = village.loadMessages();
-    unsigned long lastMsgTime = 0;
-    for (const auto& msg : messages) {
-      if (msg.timestamp > lastMsgTime) {
-        lastMsgTime = msg.timestamp;
-      }
-    }
+    // Get timestamp of most recent message for sync optimization (from the index, no file scan)
+    unsigned long lastMsgTime = village.getLatestMessageTimestamp();
     
     mqttMessenger.requestSync(lastMsgTime);
     lastPeriodicSync = millis();
     Serial.println("[App] Periodic sync requested (last message: " + String(lastMsgTime) + ")");
     logger.info("Periodic sync requested");
   }
+}
+
+void loggerTask() {
+  // Checks for serial connection, processes commands
+  logger.update();
+}
+
+void indexTask() {
+  // Writes the conversation manifest once message activity has settled
+  conversationIndex.update();
+}
+
+void appTask() {
+  uint32_t keysBefore = keyboard.getKeyCount();
   
-  // Check for inactivity timeout - enter napping mode after 5 minutes
-  // BUT: Skip sleep if USB powered (for debugging and real-time updates)
-  if (powerMode == POWER_AWAKE && !isUsbPowered()) {
-    unsigned long inactiveTime = millis() - lastActivityTime;
-    if (inactiveTime >= AWAKE_TIMEOUT) {
-      Serial.println("[Power] 5 minutes of inactivity - entering napping mode");
-      logger.info("Power: Entering nap mode after inactivity");
-      powerMode = POWER_NAPPING;
-      sleepBatteryVoltage = battery.getVoltage();
-      enterDeepSleep();
-      // Never returns - device enters deep sleep
+  // Set active village for sending messages (all villages remain subscribed for receiving)
+  static String lastActiveVillageId = "";
+  if (village.isInitialized()) {
+    String currentVillageId = village.getVillageId();
+    if (currentVillageId != lastActiveVillageId) {
+      // Village changed - set as active for sending
+      mqttMessenger.setActiveVillage(currentVillageId);
+      lastActiveVillageId = currentVillageId;
+      Serial.println("[Loop] Active village set to: " + village.getVillageName());
     }
+  } else if (!lastActiveVillageId.isEmpty()) {
+    // Village was cleared - reset tracking
+    lastActiveVillageId = "";
   }
   
   switch (appState) {
@@ -1243,7 +1591,48 @@ void setup() {
       break;
   }
   
-  smartDelay(5);  // Faster loop = more keyboard polling
+  // The handler had its chance at keys read before it ran - unhandled ones must not
+  // block the keys queued behind them
+  keyboard.dropUnhandledKey(keysBefore);
+  if (keyboard.hasPendingKeys()) {
+    scheduler.signal(taskKeyboard);  // Next queued key
+  }
+  
+  // Messages received on the MQTT task join the history window here, then any redraw
+  // requested from callbacks is flushed (coalesced to one frame per interval)
+  ui.applyPostedMessages();
+  ui.serviceFrame();
+}
+
+// Runs on the keyboard reader task (KEYBOARD_USE_INTERRUPT)
+void signalKeyboardTask() {
+  scheduler.signal(taskKeyboard);
+}
+
+void registerTasks() {
+  // Keyboard first: it wins ties with the app task, so a key is read before it's handled
+  taskKeyboard = scheduler.addTask("keyboard", keyboardTask, KEYBOARD_ACTIVE_POLL_MS, 20, PRIORITY_HIGH, true);
+#ifdef KEYBOARD_USE_INTERRUPT
+  if (keyboard.beginInterrupt(KEYBOARD_INT_PIN, signalKeyboardTask)) {
+    scheduler.setPeriod(taskKeyboard, 0);  // Event-driven only - no I2C at rest
+  }
+#endif
+  taskApp = scheduler.addTask("app", appTask, 50, 50, PRIORITY_HIGH);
+  scheduler.addTask("power", powerTask, 100, 200, PRIORITY_NORMAL);
+  scheduler.addTask("network", networkTask, 100, 500, PRIORITY_NORMAL);
+  scheduler.addTask("mqtt", mqttTask, 100, 500, PRIORITY_NORMAL, true);
+  taskBoot = scheduler.addTask("boot", serviceDeferredBoot, 1, 1000, PRIORITY_NORMAL);
+  scheduler.addTask("logger", loggerTask, 200, 500, PRIORITY_LOW);
+  scheduler.addTask("battery", batteryTask, 1000, 5000, PRIORITY_LOW);
+  scheduler.addTask("index", indexTask, 1000, 5000, PRIORITY_LOW);
+  scheduler.addTask("sync", syncTask, 1000, 5000, PRIORITY_LOW);
+  
+  // Sleep between tasks; a key press (CardKB INT low) wakes straight into the keyboard task
+  scheduler.enableLightSleep((gpio_num_t)KEYBOARD_INT_PIN, taskKeyboard, canLightSleep);
+}
+
+void loop() {
+  scheduler.run();
 }
 
 void handleMainMenu() {
@@ -1445,13 +1834,7 @@ void handleVillageMenu() {
       ui.resetMessageScroll();  // Reset scroll to show latest messages
       
       // Request message sync when entering messaging screen
-      std::vector<Message> existingMsgs = village.loadMessages();
-      unsigned long lastMsgTime = 0;
-      for (const auto& msg : existingMsgs) {
-        if (msg.timestamp > lastMsgTime) {
-          lastMsgTime = msg.timestamp;
-        }
-      }
+      unsigned long lastMsgTime = village.getLatestMessageTimestamp();
       if (mqttMessenger.isConnected()) {
         Serial.println("[Sync] Requesting sync on entering messages: last timestamp=" + String(lastMsgTime));
         logger.info("Sync: Request sent, last=" + String(lastMsgTime));
@@ -1460,21 +1843,8 @@ void handleVillageMenu() {
       }
       
       // Load messages with pagination - show last N messages (same window for both devices)
-      ui.clearMessages();  // Clear any old messages from UI
-      std::vector<Message> messages = village.loadMessages();
-      Serial.println("[Village] Loaded " + String(messages.size()) + " messages from storage");
-      
-      // Calculate pagination: always show last MAX_MESSAGES_TO_LOAD messages
-      // This ensures both devices see the SAME window of recent conversation
-      int startIndex = messages.size() > MAX_MESSAGES_TO_LOAD ? messages.size() - MAX_MESSAGES_TO_LOAD : 0;
-      int displayCount = 0;
-      
-      // Add paginated messages to UI (same chunk for all devices)
-      for (int i = startIndex; i < messages.size(); i++) {
-        ui.addMessage(messages[i]);
-        displayCount++;
-      }
-      Serial.println("[App] Displaying last " + String(displayCount) + " of " + String(messages.size()) + " messages (paginated, consistent across devices)");
+      // Older history is paged in from flash as the user scrolls up
+      loadRecentMessagesIntoUI();
       
       // ...removed markVisibleMessagesAsRead();
       
@@ -1525,6 +1895,7 @@ void handleVillageMenu() {
           ui.updateClean();  // Clean transition
           break;
         }
+        keyboard.dropSpecialKey();
         smartDelay(50);
       }
     }
@@ -1853,18 +2224,10 @@ void handleUsernameInput() {
         );
         
         // Load messages and go to messaging screen (skip invite code flow continuation)
-        ui.clearMessages();
-        std::vector<Message> messages = village.loadMessages();
-        int startIndex = messages.size() > MAX_MESSAGES_TO_LOAD ? messages.size() - MAX_MESSAGES_TO_LOAD : 0;
-        for (int i = startIndex; i < messages.size(); i++) {
-          ui.addMessage(messages[i]);
-        }
+        loadRecentMessagesIntoUI();
         
         // Request sync
-        unsigned long lastMsgTime = 0;
-        for (const auto& msg : messages) {
-          if (msg.timestamp > lastMsgTime) lastMsgTime = msg.timestamp;
-        }
+        unsigned long lastMsgTime = village.getLatestMessageTimestamp();
         if (mqttMessenger.isConnected()) {
           mqttMessenger.requestSync(lastMsgTime);
           smartDelay(500);
@@ -1896,7 +2259,7 @@ void handleUsernameInput() {
       
       // If not found, find first empty slot
       if (currentVillageSlot == -1) {
-        for (int i = 0; i < 10; i++) {
+        for (int i = 0; i < MAX_VILLAGE_SLOTS; i++) {
           if (!Village::hasVillageInSlot(i)) {
             currentVillageSlot = i;
             Serial.println("[Main] Using empty slot: " + String(i));
@@ -1977,6 +2340,7 @@ void handleUsernameInput() {
         
         // Wait for enter key to continue
         while (!keyboard.isEnterPressed() && !keyboard.isRightPressed()) {
+          keyboard.dropSpecialKey();
           keyboard.update();
           smartDelay(50);
         }
@@ -2001,21 +2365,8 @@ void handleUsernameInput() {
       keyboard.clearInput();  // MOVED: Clear buffer AFTER state transition to prevent residual chars
       
       // Load messages with pagination - show last N messages (same window for both devices)
-      ui.clearMessages();  // Clear any old messages from UI
-      std::vector<Message> messages = village.loadMessages();
-      Serial.println("[Village] Loaded " + String(messages.size()) + " messages from storage");
-      
-      // Calculate pagination: always show last MAX_MESSAGES_TO_LOAD messages
-      // This ensures both devices see the SAME window of recent conversation
-      int startIndex = messages.size() > MAX_MESSAGES_TO_LOAD ? messages.size() - MAX_MESSAGES_TO_LOAD : 0;
-      int displayCount = 0;
-      
-      // Add paginated messages to UI (same chunk for all devices)
-      for (int i = startIndex; i < messages.size(); i++) {
-        ui.addMessage(messages[i]);
-        displayCount++;
-      }
-      Serial.println("[App] Displaying last " + String(displayCount) + " of " + String(messages.size()) + " messages (paginated, consistent across devices)");
+      // Older history is paged in from flash as the user scrolls up
+      loadRecentMessagesIntoUI();
       
       // Mark unread messages as read
       
@@ -2049,13 +2400,7 @@ void handleVillageCreated() {
     ui.setCurrentUsername(village.getUsername());  // Set username
     
     // Clear old messages and load messages for current conversation
-    ui.clearMessages();
-    std::vector<Message> messages = village.loadMessages();
-    int startIndex = messages.size() > MAX_MESSAGES_TO_LOAD ? messages.size() - MAX_MESSAGES_TO_LOAD : 0;
-    for (int i = startIndex; i < messages.size(); i++) {
-      ui.addMessage(messages[i]);
-    }
-    Serial.println("[VillageCreated] Back pressed: Loaded " + String(messages.size() - startIndex) + " of " + String(messages.size()) + " messages");
+    loadRecentMessagesIntoUI();
     
     appState = APP_MESSAGING;
     inMessagingScreen = true;
@@ -2151,6 +2496,7 @@ void handleInviteExplain() {
         logger.error("Invite code publish failed");
       }
       
+      joinerPending = false;  // Left over from an earlier invite
       appState = APP_INVITE_CODE_DISPLAY;
       ui.setState(STATE_INVITE_CODE_DISPLAY);
       ui.updateClean();
@@ -2165,9 +2511,48 @@ void handleInviteExplain() {
   }
 }
 
+// Runs on the loop task once onMessageReceived() saw the join announcement
+void showJoinerJoined() {
+  Serial.println("[Invite] New member joined - showing success message instead of auto-transitioning");
+  String code = ui.getInviteCode();
+  ui.clearInviteCode();
+  // Unpublish invite
+  if (!code.isEmpty()) {
+    mqttMessenger.unsubscribeFromInvite(code);
+    mqttMessenger.unpublishInvite(code);
+  }
+  
+  // Show success message and wait for user to proceed
+  ui.showMessage("Success!", joinerName + " joined!\n\nPress ENTER\nto continue", 0);
+  keyboard.clearInput();
+  waitForEnter();
+  keyboard.clearInput();
+  
+  // FIXED: Properly initialize messaging screen (same as normal entry path)
+  ui.setInputText("");  // Clear any text in input field
+  ui.setCurrentUsername(village.getUsername());  // Set username for message display
+  
+  // Load messages from storage
+  loadRecentMessagesIntoUI();
+  
+  // Transition to messaging
+  appState = APP_MESSAGING;
+  ui.setState(STATE_MESSAGING);
+  inMessagingScreen = true;
+  lastMessagingActivity = millis();
+  // ...removed markVisibleMessagesAsRead();
+  ui.update();
+}
+
 void handleInviteCodeDisplay() {
   keyboard.update();
   
+  if (joinerPending) {
+    joinerPending = false;
+    showJoinerJoined();
+    return;
+  }
+  
   // Check if code expired
   if (millis() > ui.getInviteExpiry()) {
     String code = ui.getInviteCode();
@@ -2211,7 +2596,6 @@ void handleInviteCodeDisplay() {
   
   // Refresh display to update countdown timer every second
   // FIXED: Check if we're still in invite display state before refreshing
-  // (auto-transition might have changed appState during message callback)
   static unsigned long lastRefresh = 0;
   if (appState == APP_INVITE_CODE_DISPLAY && millis() - lastRefresh > 1000) {
     ui.updatePartial();
@@ -2327,7 +2711,7 @@ void handleJoinCodeInput() {
         logger.error("Join failed: MQTT not connected");
         ui.showMessage("Error", "Not connected\nto network\n\nPress ENTER", 0);
         keyboard.clearInput();
-        while (!keyboard.isEnterPressed()) { keyboard.update(); smartDelay(50); }
+        waitForEnter();
         keyboard.clearInput();
         appState = APP_MAIN_MENU;
         ui.setState(STATE_MAIN_HUB);
@@ -2363,7 +2747,7 @@ void handleJoinCodeInput() {
           
           // Find available slot
           int slot = -1;
-          for (int i = 0; i < 10; i++) {
+          for (int i = 0; i < MAX_VILLAGE_SLOTS; i++) {
             if (!Village::hasVillageInSlot(i)) {
               slot = i;
               break;
@@ -2395,6 +2779,8 @@ void handleJoinCodeInput() {
             if (file) {
               serializeJson(doc, file);
               file.close();
+              Village::refreshSlot(slot);  // Written directly, bypassing saveToSlot()
+              conversationIndex.updateSlot(slot, pendingInvite.villageId, pendingInvite.villageName);
               
               Serial.println("[Invite] Village saved to slot " + String(slot));
               logger.info("Joined village: " + pendingInvite.villageName);
@@ -2429,7 +2815,7 @@ void handleJoinCodeInput() {
               } else {
                 Serial.println("[Invite] Failed to load village after save");
                 ui.showMessage("Error", "Failed to load\nvillage data\n\nPress ENTER", 0);
-                while (!keyboard.isEnterPressed()) { keyboard.update(); smartDelay(50); }
+                waitForEnter();
                 appState = APP_MAIN_MENU;
                 ui.setState(STATE_MAIN_HUB);
                 ui.resetMenuSelection();
@@ -2438,7 +2824,7 @@ void handleJoinCodeInput() {
             } else {
               Serial.println("[Invite] Failed to save village");
               ui.showMessage("Error", "Failed to save\nvillage data\n\nPress ENTER", 0);
-              while (!keyboard.isEnterPressed()) { keyboard.update(); smartDelay(50); }
+              waitForEnter();
               appState = APP_MAIN_MENU;
               ui.setState(STATE_MAIN_HUB);
               ui.resetMenuSelection();
@@ -2447,7 +2833,7 @@ void handleJoinCodeInput() {
           } else {
             Serial.println("[Invite] No available slots");
             ui.showMessage("Error", "No available slots\n(max 10 conversations)\n\nPress ENTER", 0);
-            while (!keyboard.isEnterPressed()) { keyboard.update(); smartDelay(50); }
+            waitForEnter();
             appState = APP_MAIN_MENU;
             ui.setState(STATE_MAIN_HUB);
             ui.resetMenuSelection();
@@ -2461,7 +2847,7 @@ void handleJoinCodeInput() {
           String errorMsg = "Code not found\nor has expired\n\nCheck the code\nand try again\n\nPress ENTER";
           ui.showMessage("Not Found", errorMsg, 0);
           keyboard.clearInput();  // Clear any buffered input before waiting
-          while (!keyboard.isEnterPressed()) { keyboard.update(); smartDelay(50); }
+          waitForEnter();
           keyboard.clearInput();  // Clear ENTER press that exited the loop
           appState = APP_JOIN_CODE_INPUT;  // Return to code entry to try again
           ui.setState(STATE_JOIN_CODE_INPUT);
@@ -2471,7 +2857,7 @@ void handleJoinCodeInput() {
       } else {
         Serial.println("[Invite] Failed to subscribe to invite topic");
         ui.showMessage("Error", "Network error\n\nPlease try again\n\nPress ENTER", 0);
-        while (!keyboard.isEnterPressed()) { keyboard.update(); smartDelay(50); }
+        waitForEnter();
         appState = APP_MAIN_MENU;
         ui.setState(STATE_MAIN_HUB);
         ui.resetMenuSelection();
@@ -2533,15 +2919,7 @@ void handleJoinUsernameInput() {
       logger.info("User joined: " + currentName);
       
       // Clear old messages and load messages for this conversation
-      ui.clearMessages();
-      std::vector<Message> messages = village.loadMessages();
-      
-      // Calculate pagination: show last MAX_MESSAGES_TO_LOAD messages
-      int startIndex = messages.size() > MAX_MESSAGES_TO_LOAD ? messages.size() - MAX_MESSAGES_TO_LOAD : 0;
-      for (int i = startIndex; i < messages.size(); i++) {
-        ui.addMessage(messages[i]);
-      }
-      Serial.println("[Join] Displaying " + String(messages.size() - startIndex) + " of " + String(messages.size()) + " messages");
+      loadRecentMessagesIntoUI();
       
       // Request sync to get historical messages (e.g., creator's join message)
       // Pass 0 to get all messages since this is a new join
@@ -2599,7 +2977,7 @@ void handleMessaging() {
   if (keyboard.isBackspacePressed()) {
     if (ui.getInputText().length() > 0) {
       ui.removeInputChar();
-      ui.updatePartial();
+      ui.updateInputLine();
       lastMessagingActivity = millis();  // Update timestamp after backspace
     }
     lastKeyPress = millis();
@@ -2615,6 +2993,7 @@ void handleMessaging() {
     }
     
     inMessagingScreen = false;  // Clear flag - leaving messages
+    conversationIndex.setViewing("");
     lastMessagingActivity = millis();
     appState = APP_CONVERSATION_MENU;
     ui.setState(STATE_CONVERSATION_MENU);
@@ -2650,7 +3029,7 @@ void handleMessaging() {
   if (keyboard.isBackspacePressed()) {
     if (ui.getInputText().length() > 0) {
       ui.removeInputChar();
-      ui.updatePartial();
+      ui.updateInputLine();
       lastMessagingActivity = millis();  // Update timestamp after backspace
     }
     lastKeyPress = millis();
@@ -2664,7 +3043,7 @@ void handleMessaging() {
     if (messageText.length() > 0) {
       // Show "Sending..." feedback immediately
       ui.setInputText("Sending...");
-      ui.updatePartial();  // Quick partial update to show sending feedback
+      ui.updateInputLine();  // Quick input-line refresh to show sending feedback
       
       // Send the message via MQTT
       
@@ -2692,11 +3071,10 @@ void handleMessaging() {
       localMsg.status = MSG_SENT;
       localMsg.messageId = sentMessageId;  // Use the actual ID from MQTT
       localMsg.villageId = String(village.getVillageId());  // Set village ID
+      // Save to storage, then show it (the store position is its history cursor)
+      village.saveMessage(localMsg, &localMsg.storeOffset);
       ui.addMessage(localMsg);
       
-      // Save to storage
-      village.saveMessage(localMsg);
-      
       // Clear input and scroll to bottom to show the message we just sent
       ui.setInputText("");
       ui.resetMessageScroll();
@@ -2720,7 +3098,7 @@ void handleMessaging() {
     // Clear the keyboard buffer after processing so we don't re-add same chars
     keyboard.clearInput();
     
-    ui.updatePartial();
+    ui.updateInputLine();  // Echo just the input line - the message area is unchanged
     lastMessagingActivity = millis();  // Update timestamp after typing
   }
 }
@@ -2790,12 +3168,11 @@ void handleMessageCompose() {
       sentMsg.messageId = messageId;
       sentMsg.status = messageId.isEmpty() ? MSG_SENT : MSG_SENT;
       sentMsg.villageId = String(village.getVillageId());  // Set village ID
-      ui.addMessage(sentMsg);
-      
       // Save message to disk
       if (!messageId.isEmpty()) {
-        village.saveMessage(sentMsg);
+        village.saveMessage(sentMsg, &sentMsg.storeOffset);
       }
+      ui.addMessage(sentMsg);
       
       // Clear input and switch to messaging view
       ui.setInputText("");
@@ -2883,8 +3260,8 @@ void handleSettingsMenu() {
       ui.setInputText("Checking...\nCurrent: " + String(FIRMWARE_VERSION));
       ui.update();
       
-      // Perform check (blocking)
-      if (otaUpdater.checkForUpdate()) {
+      // Perform check (blocking) - user asked, so skip the cached manifest
+      if (otaUpdater.checkForUpdate(true)) {
         String updateInfo = "Update Available!\n";
         updateInfo += "New version: " + otaUpdater.getLatestVersion() + "\n";
         updateInfo += "Current: " + otaUpdater.getCurrentVersion();
@@ -2953,6 +3330,31 @@ void handleRingtoneSelect() {
   }
 }
 
+// Push the cached scan results to the network list screen
+const unsigned long NETWORK_LIST_RESCAN_AGE = 30000;  // Rescan if the cache is older than 30s
+uint32_t shownScanGeneration = 0;
+
+void showScannedNetworks() {
+  auto networks = wifiManager.getScanResults();
+  
+  // Convert to vectors for UI
+  std::vector<String> ssids;
+  std::vector<int> rssis;
+  std::vector<bool> encrypted;
+  std::vector<bool> saved;
+  
+  for (const auto& net : networks) {
+    ssids.push_back(net.ssid);
+    rssis.push_back(net.rssi);
+    encrypted.push_back(net.encrypted);
+    saved.push_back(net.saved);
+  }
+  
+  ui.setNetworkList(ssids, rssis, encrypted, saved);
+  ui.setNetworkScanning(wifiManager.isScanning());
+  shownScanGeneration = wifiManager.getScanGeneration();
+}
+
 void handleWiFiSetupMenu() {
   if (keyboard.isUpPressed()) {
     ui.menuUp();
@@ -3030,26 +3432,12 @@ void handleWiFiSetupMenu() {
         ui.updateClean();
       }
     } else if ((savedCount > 0 && selection == 1) || (savedCount == 0 && selection == 0)) {
-      // Scan for networks
-      Serial.println("[WiFi] Scanning for networks...");
-      ui.showMessage("WiFi", "Scanning...", 1000);
-      
-      auto networks = wifiManager.scanNetworks();
-      
-      // Convert to vectors for UI
-      std::vector<String> ssids;
-      std::vector<int> rssis;
-      std::vector<bool> encrypted;
-      std::vector<bool> saved;
-      
-      for (const auto& net : networks) {
-        ssids.push_back(net.ssid);
-        rssis.push_back(net.rssi);
-        encrypted.push_back(net.encrypted);
-        saved.push_back(net.saved);
+      // Show the cached scan right away and refresh it in the background -
+      // handleWiFiNetworkList() redraws in place when the new results land
+      if (wifiManager.getScanAge() > NETWORK_LIST_RESCAN_AGE) {
+        wifiManager.startScan();
       }
-      
-      ui.setNetworkList(ssids, rssis, encrypted, saved);
+      showScannedNetworks();
       
       keyboard.clearInput();
       appState = APP_WIFI_NETWORK_LIST;
@@ -3063,6 +3451,13 @@ void handleWiFiSetupMenu() {
 }
 
 void handleWiFiNetworkList() {
+  // Background scan finished (or failed) - refresh the list in place
+  if (wifiManager.getScanGeneration() != shownScanGeneration ||
+      (ui.getNetworkScanning() && !wifiManager.isScanning())) {
+    showScannedNetworks();
+    ui.requestUpdate();
+  }
+  
   if (keyboard.isUpPressed()) {
     ui.menuUp();
     ui.updateClean();
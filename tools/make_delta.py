@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Build a delta OTA patch between two SmolTxt firmware images.
+
+    python tools/make_delta.py releases/firmware-v0.56.20.bin \
+        .pio/build/heltec_vision_master_e290/firmware.bin \
+        releases/firmware-delta-v0.56.20.patch
+
+The patch is named after the version it applies TO (the old image): a device running
+v0.56.20 looks for firmware-delta-v0.56.20.patch in the latest release and falls back
+to the full firmware.bin when there isn't one. Format is documented in
+src/DeltaPatcher.h - keep the two in sync.
+
+No dependencies beyond the standard library. The patch is applied back to the old
+image before writing, so a bad patch never leaves this script.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import zlib
+
+MAGIC = b"SMOLDLT1"
+KEY_LEN = 8          # Bytes hashed to find match candidates in the old image
+GIVE_UP = 32         # Stop extending a match once mismatches lead by this much
+
+
+def index_old(old):
+    """First position of every KEY_LEN-byte window in the old image."""
+    index = {}
+    for pos in range(len(old) - KEY_LEN + 1):
+        index.setdefault(old[pos:pos + KEY_LEN], pos)
+    return index
+
+
+def extend(old, new, old_pos, new_pos):
+    """Length of the best approximate match starting at (old_pos, new_pos).
+
+    bsdiff-style: mismatched bytes are allowed inside a match (they become non-zero
+    add bytes), as long as matching bytes keep the lead.
+    """
+    score = best = best_len = 0
+    length = 0
+    limit = min(len(old) - old_pos, len(new) - new_pos)
+    while length < limit:
+        score += 1 if old[old_pos + length] == new[new_pos + length] else -1
+        length += 1
+        if score > best:
+            best, best_len = score, length
+        elif score < best - GIVE_UP:
+            break
+    return best_len
+
+
+def find_matches(old, new):
+    """Non-overlapping (new_pos, old_pos, length) matches in new-image order."""
+    index = index_old(old)
+    matches = []
+    pos = 0
+    while pos <= len(new) - KEY_LEN:
+        key = new[pos:pos + KEY_LEN]
+
+        # Prefer continuing the previous alignment - code that shifted by a constant
+        candidate = None
+        if matches:
+            prev_new, prev_old, _ = matches[-1]
+            predicted = prev_old + (pos - prev_new)
+            if old[predicted:predicted + KEY_LEN] == key:
+                candidate = predicted
+        if candidate is None:
+            candidate = index.get(key)
+        if candidate is None:
+            pos += 1
+            continue
+
+        length = extend(old, new, candidate, pos)
+        if length < KEY_LEN:
+            pos += 1
+            continue
+        matches.append((pos, candidate, length))
+        pos += length
+    return matches
+
+
+def build_body(old, new, matches):
+    """Serialize matches as add/copy/seek records."""
+    body = bytearray()
+    old_cursor = 0
+    new_cursor = 0
+
+    def record(add_from, add_len, copy_end, next_old):
+        nonlocal old_cursor, new_cursor
+        body.extend(struct.pack("<iii", add_len, copy_end - new_cursor - add_len,
+                                next_old - (old_cursor + add_len)))
+        for i in range(add_len):
+            body.append((new[new_cursor + i] - old[add_from + i]) & 0xFF)
+        body.extend(new[new_cursor + add_len:copy_end])
+        old_cursor = next_old
+        new_cursor = copy_end
+
+    # Leading literal bytes before the first match
+    # (always emitted - it also seeks the device's old cursor to the first match)
+    first_old = matches[0][1] if matches else 0
+    first_new = matches[0][0] if matches else len(new)
+    record(0, 0, first_new, first_old)
+
+    for i, (new_pos, old_pos, length) in enumerate(matches):
+        next_new, next_old = (matches[i + 1][0], matches[i + 1][1]) if i + 1 < len(matches) else (len(new), old_pos + length)
+        record(old_pos, length, next_new, next_old)
+
+    return bytes(body)
+
+
+def apply_patch(old, patch):
+    """Reference implementation of the device-side applier, used to verify."""
+    if patch[:8] != MAGIC:
+        raise ValueError("bad magic")
+    old_size, new_size = struct.unpack_from("<II", patch, 8)
+    if hashlib.sha256(old[:old_size]).digest() != patch[16:48]:
+        raise ValueError("base hash mismatch")
+    body = zlib.decompress(patch[80:])
+
+    out = bytearray()
+    old_pos = 0
+    offset = 0
+    while len(out) < new_size:
+        add_len, copy_len, seek = struct.unpack_from("<iii", body, offset)
+        offset += 12
+        for i in range(add_len):
+            out.append((body[offset + i] + old[old_pos + i]) & 0xFF)
+        offset += add_len
+        old_pos += add_len
+        out.extend(body[offset:offset + copy_len])
+        offset += copy_len
+        old_pos += seek
+    if offset != len(body) or hashlib.sha256(out).digest() != patch[48:80]:
+        raise ValueError("patched image does not match")
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old", help="firmware.bin the devices are running")
+    parser.add_argument("new", help="firmware.bin being released")
+    parser.add_argument("patch", help="output .patch file")
+    args = parser.parse_args()
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    matches = find_matches(old, new)
+    body = build_body(old, new, matches)
+
+    header = MAGIC + struct.pack("<II", len(old), len(new))
+    header += hashlib.sha256(old).digest() + hashlib.sha256(new).digest()
+    patch = header + zlib.compress(body, 9)
+
+    apply_patch(old, patch)
+
+    with open(args.patch, "wb") as f:
+        f.write(patch)
+
+    print("Delta: %d -> %d bytes, patch %d bytes (%.1f%% of full image)"
+          % (len(old), len(new), len(patch), 100.0 * len(patch) / len(new)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Local stand-in for the GitHub release CDN, for testing resumable OTA.
+
+    python tools/ota_test_server.py releases/firmware-v0.56.21.bin --drop-after 600000
+
+Serves the image at http://<host>:8080/firmware.bin (with Range support) and its
+SHA-256 at /firmware.bin.sha256. Point a device at it with
+otaUpdater.setCustomURL("http://<host>:8080/firmware.bin").
+
+  --drop-after N   cut the first N connections short after N bytes, to exercise resume
+  --drops K        how many connections to cut (default 1)
+  --no-range       ignore Range headers, like a server without resume support
+  --rate BPS       throttle the body, so a drop can be triggered by hand (Wi-Fi off)
+"""
+
+import argparse
+import hashlib
+import http.server
+import re
+import time
+
+
+def make_handler(image, digest, args):
+    state = {"drops": 0}
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        def do_GET(self):
+            if self.path == "/firmware.bin.sha256":
+                body = ("%s  firmware.bin\n" % digest).encode()
+                self.send_response(200)
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+                return
+            if self.path != "/firmware.bin":
+                self.send_error(404)
+                return
+
+            start = 0
+            match = re.match(r"bytes=(\d+)-$", self.headers.get("Range", ""))
+            if match and not args.no_range:
+                start = int(match.group(1))
+                if start >= len(image):
+                    self.send_error(416)
+                    return
+                self.send_response(206)
+                self.send_header("Content-Range", "bytes %d-%d/%d" % (start, len(image) - 1, len(image)))
+            else:
+                self.send_response(200)
+            self.send_header("Content-Length", str(len(image) - start))
+            self.send_header("Accept-Ranges", "none" if args.no_range else "bytes")
+            self.end_headers()
+
+            # Cut this connection short?
+            end = len(image)
+            if args.drop_after and state["drops"] < args.drops:
+                state["drops"] += 1
+                end = min(end, start + args.drop_after)
+                self.log_message("dropping after %d bytes", end - start)
+
+            pos = start
+            while pos < end:
+                chunk = image[pos:min(pos + 4096, end)]
+                self.wfile.write(chunk)
+                pos += len(chunk)
+                if args.rate:
+                    time.sleep(len(chunk) / float(args.rate))
+
+            if end < len(image):
+                self.close_connection = True
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("image", help="firmware.bin to serve")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--drop-after", type=int, default=0)
+    parser.add_argument("--drops", type=int, default=1)
+    parser.add_argument("--no-range", action="store_true")
+    parser.add_argument("--rate", type=int, default=0)
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    digest = hashlib.sha256(image).hexdigest()
+
+    server = http.server.ThreadingHTTPServer(("", args.port), make_handler(image, digest, args))
+    print("Serving %s (%d bytes, sha256 %s) on port %d" % (args.image, len(image), digest, args.port))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()